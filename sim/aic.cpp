@@ -1,9 +1,11 @@
 
 #include "aic.h"
+#include "config/config.h"
 #include "util/log.h"
 #include "util/case_io.h"
 #include "util/utils.h"
 #include <fstream>
+#include <algorithm>
 #include <filesystem>
 
 // preload_into_mem moved to util/case_io
@@ -41,12 +43,54 @@ void AIC::build(const std::string& case_toml_path, bool force) {
   // If cube not yet constructed, or model config changed, or force requested,
   // create/recreate the Cube instance. Use case TOML's referenced model_cfg
   // or fall back to the default "model_cfg.toml".
-  if (!cube_ || force) {
+  //
+  // aic.cubes > 1 builds that many cubes on the same clock and memory instead.
+  const int cubes = std::max(1, get<int>("aic.cubes").value_or(1));
+  partition_ = get<CubePartition>("aic.partition").value_or(CubePartition::M);
+  if (cubes > 1) {
+    if (!cluster_ || cluster_->size() != cubes || force) {
+      cube_.reset();
+      cluster_.reset();
+      cluster_.reset(new CubeCluster(clk_, mem_, cubes));
+    }
+  } else if (!cube_ || force) {
+    cluster_.reset();
     cube_.reset();
     cube_ = p_cube_t(new Cube(clk_, mem_));
   }
 }
 
+// Cut the case's GEMM into one slice per cube along M (row blocks of A and C)
+// or N (column blocks of B and C), in whole tiles, so no tile straddles two
+// cubes. Trailing cubes get nothing when there are fewer tiles than cubes.
+std::vector<GemmDesc> AIC::split_gemm() const {
+  const int M = case_cfg_.M, N = case_cfg_.N, K = case_cfg_.K;
+  const TileBlocks blocks = tile_blocks(cluster_->cube(0)->get_array()->perf_model_params());
+  const bool by_m = partition_ == CubePartition::M;
+  const int extent = by_m ? M : N;
+  const int unit = by_m ? blocks.m : blocks.n;
+  const int tiles = (extent + unit - 1) / unit;
+  const int per_cube = (tiles + cluster_->size() - 1) / cluster_->size();
+
+  std::vector<GemmDesc> slices;
+  for (int lo = 0; lo < extent; lo += per_cube * unit) {
+    const int len = std::min(per_cube * unit, extent - lo);
+    GemmDesc g;
+    g.M = by_m ? len : M;
+    g.N = by_m ? N : len;
+    g.K = K;
+    g.lda = K;
+    g.ldb = N;
+    g.ldc = N;
+    const Addr off = static_cast<Addr>(lo);
+    g.a_addr = case_cfg_.a_addr + (by_m ? off * static_cast<Addr>(K) : 0);
+    g.b_addr = case_cfg_.b_addr + (by_m ? 0 : off);
+    g.c_addr = case_cfg_.c_addr + (by_m ? off * static_cast<Addr>(N) : off);
+    slices.push_back(g);
+  }
+  return slices;
+}
+
 bool AIC::start() {
   if (case_cfg_.case_path.empty()) {
     LOG_ERROR("AIC::start: no case configured; call build(case_toml) first");
@@ -56,19 +100,48 @@ bool AIC::start() {
   std::vector<DataType> B;
   std::vector<AccType> C;
 
-  if (!util::read_bins_from_cfg(case_cfg_, A, B)) return false;
-  (void)case_cfg_; // avoid unused warning if fields not referenced later
-
-  preload_into_mem(case_cfg_, A, B);
+  // memory.mmap_preload: map the case binaries copy-on-write straight into
+  // Mem instead of reading them into host vectors and copying them in.
+  if (get<bool>("memory.mmap_preload").value_or(true) && mem_) {
+    if (!mem_->map_file(case_cfg_.a_path, case_cfg_.a_addr)) {
+      LOG_ERROR("AIC::start: failed to map A from {}", case_cfg_.a_path);
+      return false;
+    }
+    if (!mem_->map_file(case_cfg_.b_path, case_cfg_.b_addr)) {
+      LOG_ERROR("AIC::start: failed to map B from {}", case_cfg_.b_path);
+      return false;
+    }
+  } else {
+    if (!util::read_bins_from_cfg(case_cfg_, A, B)) return false;
+    preload_into_mem(case_cfg_, A, B);
+  }
 
-  if (!cube_) {
+  if (!cube_ && !cluster_) {
     LOG_ERROR("AIC::start: cube not constructed; call build(case_toml) first");
     return false;
   }
 
-  bool ok = cube_->run(case_cfg_.M, case_cfg_.N, case_cfg_.K,
-                       case_cfg_.a_addr, case_cfg_.b_addr, case_cfg_.c_addr);
-  if (!ok) return false;
+  Fidelity fidelity;
+  if (cluster_) {
+    if (!cluster_->run(split_gemm())) return false;
+    reports_ = cluster_->get_reports();
+    fidelity = cluster_->cube(0)->get_fidelity();
+    LOG_INFO("AIC: {} cubes split by {}, {} cycles", cluster_->size(),
+             partition_ == CubePartition::M ? "M" : "N", cluster_->get_cycles());
+  } else {
+    if (!cube_->run(case_cfg_.M, case_cfg_.N, case_cfg_.K,
+                    case_cfg_.a_addr, case_cfg_.b_addr, case_cfg_.c_addr)) return false;
+    reports_.assign(1, CubeCluster::report_of(*cube_));
+    fidelity = cube_->get_fidelity();
+  }
+  for (size_t i = 0; i < reports_.size(); ++i) {
+    const CubeCluster::CubeReport &r = reports_[i];
+    LOG_INFO("Cube {}: {} cycles, utilization {:.2f}%, contention {} cycles, load wait {} cycles",
+             i, r.cycles, r.utilization * 100, r.contention_cycles, r.load_cycles);
+  }
+
+  // Analytical runs only estimate timing; there is nothing to compare.
+  if (fidelity == Fidelity::ANALYTICAL) return true;
 
   // Read results back from memory
   size_t c_len = static_cast<size_t>(case_cfg_.M) * static_cast<size_t>(case_cfg_.N);
@@ -5,6 +5,7 @@
 #include <string>
 
 #include "cube.h"
+#include "cube_cluster.h"
 #include "clock.h"
 #include "mem_if.h"
 #include "config/config.h"
@@ -22,11 +23,21 @@ public:
 
     bool start();
 
+    // Per-cube utilization and memory contention of the last start(); one
+    // entry per cube (aic.cubes).
+    const std::vector<CubeCluster::CubeReport>& get_cube_reports() const { return reports_; }
+
 private:
     
     p_clock_t clk_;
     p_mem_t mem_;
     p_cube_t cube_;
+    // aic.cubes > 1: the cubes share clk_ and mem_ and each computes one
+    // slice of the GEMM, cut along aic.partition (cube_ is then unused)
+    std::unique_ptr<CubeCluster> cluster_;
+    CubePartition partition_ = CubePartition::M;
+    std::vector<CubeCluster::CubeReport> reports_;
+    std::vector<GemmDesc> split_gemm() const;
     // Helper methods
     void preload_into_mem(const util::CaseConfig &cfg, const std::vector<DataType> &A, const std::vector<DataType> &B);
     // stored case configuration (set by build)
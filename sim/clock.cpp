@@ -1,4 +1,26 @@
 #include "clock.h"
+#include "config/config.h"
+#include "util/snapshot.h"
 
 // clock.cpp — 时钟实现文件（中文注释）
-// 当前 `Clock` 的主要实现位于头文件中；保留此源文件以便构建与未来扩展。
+// 调度逻辑位于头文件中（便于内联）；此处负责构造与配置读取。
+
+Clock::Clock() : cycle_count(0), next_id(1), event_driven_(false) {
+    config();
+}
+
+void Clock::config() {
+    // Event-driven skip-ahead is opt-in; the plain per-cycle tick stays the default.
+    event_driven_ = get<bool>("clock.event_driven").value_or(false);
+}
+
+void Clock::save(util::SnapshotWriter &w) const {
+    w.tag("CLK ");
+    w.put(cycle_count);
+    w.put(event_driven_);
+}
+
+bool Clock::load(util::SnapshotReader &r) {
+    if (!r.expect_tag("CLK ")) return false;
+    return r.get(cycle_count) && r.get(event_driven_);
+}
@@ -1,6 +1,10 @@
 // clock.h — 时钟驱动器（中文注释）
 // `Clock` 提供全局周期（tick）通知机制，组件可注册监听器，按优先级执行。
 // 该模块作为仿真中各部分（内存、PE、控制器等）的驱动器。
+//
+// 事件驱动模式（event-driven）：监听器可额外提供 wake 查询（下一次需要真实 tick
+// 的绝对周期）与 skip 处理函数（批量结算若干空闲周期）。`advance()` 会直接跳到
+// 最早的唤醒周期，跳过的周期只调用 skip 处理函数，计数保持逐周期精确。
 #ifndef CLOCK_H
 #define CLOCK_H
 
@@ -8,25 +12,43 @@
 #include <functional>
 #include <algorithm>
 #include <cstdint>
+#include <limits>
 #include "types.h"
 
+namespace util { class SnapshotWriter; class SnapshotReader; }
+
 class Clock {
 public:
     using Listener = std::function<void()>;
+    // Returns the absolute cycle at which the listener next needs a real tick
+    // (Clock::NEVER when it is idle until someone else wakes it).
+    using WakeQuery = std::function<Cycle()>;
+    // Accounts for `n` idle cycles in bulk (counters, timers, ...).
+    using SkipHandler = std::function<void(Cycle)>;
+
+    static constexpr Cycle NEVER = std::numeric_limits<Cycle>::max();
 
-    Clock() : cycle_count(0), next_id(1) {}
+    // Reads `clock.event_driven` from the runtime default config (see clock.cpp).
+    Clock();
 
     // Add a listener with optional priority (lower runs earlier). Returns an id handle.
-    std::size_t add_listener(const Listener &l, int priority = 0) {
+    // `wake`/`skip` are only used in event-driven mode. Listeners without a wake
+    // query never hold back a skip; listeners without a skip handler are simply
+    // not invoked for skipped (idle) cycles.
+    std::size_t add_listener(const Listener &l, int priority = 0,
+                             const WakeQuery &wake = nullptr,
+                             const SkipHandler &skip = nullptr) {
         ListenerEntry e;
         e.id = next_id++;
         e.priority = priority;
         e.func = l;
-        listeners.push_back(e);
-        // keep listeners sorted by priority (ascending)
-        std::sort(listeners.begin(), listeners.end(), [](const ListenerEntry &a, const ListenerEntry &b){
-            return a.priority < b.priority;
-        });
+        e.wake = wake;
+        e.skip = skip;
+        // keep listeners sorted by priority (ascending); equal priorities keep
+        // registration order. Insert in place instead of re-sorting everything.
+        auto pos = std::upper_bound(listeners.begin(), listeners.end(), priority,
+                                    [](int p, const ListenerEntry &x){ return p < x.priority; });
+        listeners.insert(pos, e);
         return e.id;
     }
 
@@ -45,13 +67,72 @@ public:
         }
     }
 
+    // Earliest wake-up cycle requested by any listener (NEVER if none).
+    Cycle next_event() const {
+        Cycle earliest = NEVER;
+        for (const auto &e : listeners) {
+            if (!e.wake) continue;
+            earliest = std::min(earliest, e.wake());
+        }
+        return earliest;
+    }
+
+    // Account for `n` idle cycles without running listeners' per-cycle work.
+    void skip(Cycle n) {
+        if (n == 0) return;
+        cycle_count += n;
+        for (auto &e : listeners) {
+            if (e.skip) e.skip(n);
+        }
+    }
+
+    // Advance the clock by at least one cycle and at most `max_cycles`.
+    // In event-driven mode the idle cycles before the earliest pending wake-up
+    // are skipped and the final cycle is a real tick; otherwise this is a
+    // single tick(). Returns the number of cycles elapsed.
+    Cycle advance(Cycle max_cycles = NEVER) {
+        if (!event_driven_ || max_cycles <= 1) {
+            tick();
+            return 1;
+        }
+        Cycle wake = next_event();
+        Cycle idle = 0;
+        if (wake != NEVER) {
+            idle = wake > cycle_count + 1 ? wake - cycle_count - 1 : 0;
+        } else if (max_cycles != NEVER) {
+            idle = max_cycles - 1;
+        }
+        idle = std::min(idle, max_cycles - 1);
+        skip(idle);
+        tick();
+        return idle + 1;
+    }
+
+    void set_event_driven(bool on) { event_driven_ = on; }
+    bool event_driven() const { return event_driven_; }
+
     Cycle now() const { return cycle_count; }
 
+    // Checkpoint support: only the cycle counter and mode are state; the
+    // listener set is rebuilt by the components themselves.
+    void save(util::SnapshotWriter &w) const;
+    bool load(util::SnapshotReader &r);
+
 private:
-    struct ListenerEntry { std::size_t id; int priority; Listener func; };
+    struct ListenerEntry {
+        std::size_t id;
+        int priority;
+        Listener func;
+        WakeQuery wake;
+        SkipHandler skip;
+    };
     Cycle cycle_count;
     std::size_t next_id;
+    bool event_driven_;
     std::vector<ListenerEntry> listeners;
+
+    // Load configuration values (reads the runtime default config path).
+    void config();
 };
 
 #endif // CLOCK_H
@@ -201,6 +201,9 @@ std::optional<std::string> convert_from_string<std::string>(const std::string &s
 template<>
 std::optional<int> convert_from_string<int>(const std::string &s) { try { return std::stoi(s); } catch(...) { return std::nullopt; } }
 
+template<>
+std::optional<int64_t> convert_from_string<int64_t>(const std::string &s) { try { return static_cast<int64_t>(std::stoll(s)); } catch(...) { return std::nullopt; } }
+
 template<>
 std::optional<bool> convert_from_string<bool>(const std::string &s) {
     std::string v = util::to_lower(s);
@@ -224,6 +227,44 @@ std::optional<Dataflow> convert_from_string<Dataflow>(const std::string &s) {
     return std::nullopt;
 }
 
+template<>
+std::optional<Fidelity> convert_from_string<Fidelity>(const std::string &s) {
+    std::string up = util::to_upper(s);
+    if (up == "CYCLE") return Fidelity::CYCLE;
+    if (up == "ANALYTICAL") return Fidelity::ANALYTICAL;
+    if (up == "FUNCTIONAL") return Fidelity::FUNCTIONAL;
+    if (up == "SAMPLED") return Fidelity::SAMPLED;
+    return std::nullopt;
+}
+
+template<>
+std::optional<BufferPolicy> convert_from_string<BufferPolicy>(const std::string &s) {
+    std::string up = util::to_upper(s);
+    if (up == "LRU") return BufferPolicy::LRU;
+    if (up == "EXPLICIT") return BufferPolicy::EXPLICIT;
+    return std::nullopt;
+}
+
+template<>
+std::optional<LoopOrder> convert_from_string<LoopOrder>(const std::string &s) {
+    std::string up = util::to_upper(s);
+    if (up == "MNK") return LoopOrder::MNK;
+    if (up == "MKN") return LoopOrder::MKN;
+    if (up == "NMK") return LoopOrder::NMK;
+    if (up == "NKM") return LoopOrder::NKM;
+    if (up == "KMN") return LoopOrder::KMN;
+    if (up == "KNM") return LoopOrder::KNM;
+    return std::nullopt;
+}
+
+template<>
+std::optional<CubePartition> convert_from_string<CubePartition>(const std::string &s) {
+    std::string up = util::to_upper(s);
+    if (up == "M") return CubePartition::M;
+    if (up == "N") return CubePartition::N;
+    return std::nullopt;
+}
+
 template<typename T>
 std::optional<T> get_impl(const std::string &dotted_key, const std::string &path) {
     auto prov = get_provider();
@@ -245,10 +286,15 @@ std::optional<T> get_impl(const std::string &dotted_key, const std::string &path
 
 // explicit instantiations
 template std::optional<int> get<int>(const std::string&, const std::string&);
+template std::optional<int64_t> get<int64_t>(const std::string&, const std::string&);
 template std::optional<bool> get<bool>(const std::string&, const std::string&);
 template std::optional<double> get<double>(const std::string&, const std::string&);
 template std::optional<std::string> get<std::string>(const std::string&, const std::string&);
 template std::optional<Dataflow> get<Dataflow>(const std::string&, const std::string&);
+template std::optional<Fidelity> get<Fidelity>(const std::string&, const std::string&);
+template std::optional<BufferPolicy> get<BufferPolicy>(const std::string&, const std::string&);
+template std::optional<LoopOrder> get<LoopOrder>(const std::string&, const std::string&);
+template std::optional<CubePartition> get<CubePartition>(const std::string&, const std::string&);
 template std::optional<config::Config> get<config::Config>(const std::string&, const std::string&);
 
 template<typename T>
@@ -23,7 +23,7 @@ struct Config {
     int array_cols = 0;
     int tile_rows = 0;
     int tile_cols = 0;
-    Dataflow dataflow = Dataflow::WEIGHT_STATIONARY;
+    Dataflow dataflow = Dataflow::OUTPUT_STATIONARY;
 
     // Parse from a flat map produced by TomlParser. Returns std::nullopt on error.
     // Implementation lives in `config/config.cpp`.
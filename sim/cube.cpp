@@ -25,7 +25,52 @@ Cube::Cube(p_clock_t external_clock, p_mem_t external_mem)
 
 // Run wrapper forwards to the internal SystolicArray implementation.
 bool Cube::run(int M, int N, int K,
-                          uint32_t a_addr, uint32_t b_addr, uint32_t c_addr) {
+                          Addr a_addr, Addr b_addr, Addr c_addr) {
     return systolic_->run(M, N, K, a_addr, b_addr, c_addr);
 }
 
+
+bool Cube::start_run(int M, int N, int K,
+                     Addr a_addr, Addr b_addr, Addr c_addr) {
+    return systolic_->begin_run(M, N, K, a_addr, b_addr, c_addr);
+}
+
+bool Cube::resume(int max_tiles) {
+    return systolic_->resume(max_tiles);
+}
+
+bool Cube::finished() const {
+    return systolic_->finished();
+}
+
+bool Cube::run_batch(const std::vector<GemmDesc> &gemms) {
+    return systolic_->run_batch(gemms);
+}
+
+const std::vector<SystolicArray::Stats>& Cube::get_gemm_stats() const {
+    return systolic_->get_gemm_stats();
+}
+
+void Cube::set_fidelity(Fidelity f) {
+    systolic_->set_fidelity(f);
+}
+
+Fidelity Cube::get_fidelity() const {
+    return systolic_->get_fidelity();
+}
+
+const SystolicArray::Stats& Cube::get_stats() const {
+    return systolic_->get_stats();
+}
+
+const SystolicArray::SampleReport& Cube::get_sample_report() const {
+    return systolic_->get_sample_report();
+}
+
+bool Cube::save_checkpoint(const std::string &path) const {
+    return systolic_->save_checkpoint(path);
+}
+
+bool Cube::load_checkpoint(const std::string &path) {
+    return systolic_->load_checkpoint(path);
+}
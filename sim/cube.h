@@ -2,6 +2,7 @@
 #define CUBE_TOP_H
 
 #include <string>
+#include <vector>
 
 #include "systolic.h"
 #include "clock.h"
@@ -18,7 +19,36 @@ public:
     // Run using data already loaded into memory. `a_addr`, `b_addr`, and
     // `c_addr` are the base addresses where A, B and C (accumulators) reside.
     bool run(int M, int N, int K,
-                         uint32_t a_addr, uint32_t b_addr, uint32_t c_addr);
+                         Addr a_addr, Addr b_addr, Addr c_addr);
+
+    // Incremental run: start_run + resume(max_tiles) stop at tile boundaries
+    // so the simulation can be checkpointed and later restored / forked.
+    bool start_run(int M, int N, int K,
+                   Addr a_addr, Addr b_addr, Addr c_addr);
+    bool resume(int max_tiles = -1);
+    bool finished() const;
+
+    // Batched GEMMs: the descriptors run back to back as one tile stream
+    // (array set up once, lookahead prefetch crossing GEMM boundaries).
+    // get_stats() then covers the batch, get_gemm_stats() each GEMM.
+    bool run_batch(const std::vector<GemmDesc> &gemms);
+    const std::vector<SystolicArray::Stats>& get_gemm_stats() const;
+
+    // Fidelity of `run` (defaults to cube.fidelity). ANALYTICAL only fills
+    // the cycle statistics; no results are written to accumulator memory.
+    void set_fidelity(Fidelity f);
+    Fidelity get_fidelity() const;
+    const SystolicArray::Stats& get_stats() const;
+    // Extrapolation summary of the last Fidelity::SAMPLED run.
+    const SystolicArray::SampleReport& get_sample_report() const;
+
+    // Binary snapshot of clock, memory, array and tile-loop state.
+    bool save_checkpoint(const std::string &path) const;
+    bool load_checkpoint(const std::string &path);
+
+    // The array behind the cube, for owners that schedule several cubes on
+    // one clock and memory (CubeCluster).
+    const p_systolic_array_t &get_array() const { return systolic_; }
 
 private:
     p_clock_t clock_;
@@ -0,0 +1,159 @@
+#include "cube_cluster.h"
+#include "util/log.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+// cube_cluster.cpp — CubeCluster 实现：共享 Mem 的逐周期轮询仲裁与各 Cube 控制循环的轮流执行。
+
+CubeCluster::CubeCluster(p_clock_t clock, p_mem_t mem, int cubes)
+    : clock_(std::move(clock)), mem_(std::move(mem)), listener_id_(0), first_(0),
+      turn_(-1), elapsed_(0), cycles_(0) {
+    if (!clock_) throw std::invalid_argument("CubeCluster requires an external clock");
+    if (!mem_) throw std::invalid_argument("CubeCluster requires external memory");
+    if (cubes <= 0) throw std::invalid_argument("CubeCluster: cubes must be positive");
+
+    for (int i = 0; i < cubes; ++i) {
+        cubes_.push_back(std::make_shared<Cube>(clock_, mem_));
+        cubes_.back()->get_array()->detach_pipeline([this, i](Cycle limit) { return advance(i, limit); });
+    }
+    active_.assign(cubes_.size(), 0);
+    limits_.assign(cubes_.size(), Clock::NEVER);
+    reports_.assign(cubes_.size(), CubeReport{});
+    // Mem first, then the pipelines (see tick), as one listener in place of the cubes' own.
+    listener_id_ = clock_->add_listener([this]() { tick(); }, 0,
+                                        [this]() { return wake(); },
+                                        [this](Cycle n) { skip(n); });
+}
+
+CubeCluster::~CubeCluster() {
+    if (listener_id_) clock_->remove_listener(listener_id_);
+}
+
+// Mem once, then the pipeline of every running cube; the cube that goes
+// first (and so takes Mem's issue slots first) rotates every cycle.
+void CubeCluster::tick() {
+    mem_->cycle();
+    const size_t n = cubes_.size();
+    for (size_t k = 0; k < n; ++k) {
+        const size_t i = (first_ + k) % n;
+        if (active_[i]) cubes_[i]->get_array()->tick_pipeline();
+    }
+    first_ = (first_ + 1) % n;
+}
+
+Cycle CubeCluster::wake() const {
+    Cycle dt = mem_->cycles_until_event();
+    for (size_t i = 0; i < cubes_.size(); ++i) {
+        if (active_[i]) dt = std::min(dt, cubes_[i]->get_array()->pipeline_wake());
+    }
+    return dt == UINT64_MAX ? Clock::NEVER : clock_->now() + dt;
+}
+
+void CubeCluster::skip(Cycle n) {
+    mem_->skip(n);
+    for (size_t i = 0; i < cubes_.size(); ++i) {
+        if (active_[i]) cubes_[i]->get_array()->skip_pipeline(n);
+    }
+    // keep the rotation where n ticks would have left it
+    first_ = static_cast<size_t>((first_ + n) % cubes_.size());
+}
+
+// Clock wait of cube `cube`'s control loop: hand over to the next cube and
+// come back once the clock has moved on.
+Cycle CubeCluster::advance(int cube, Cycle limit) {
+    std::unique_lock<std::mutex> lk(mtx_);
+    limits_[static_cast<size_t>(cube)] = limit;
+    pass_turn(cube);
+    cv_.wait(lk, [this, cube] { return turn_ == cube; });
+    return elapsed_;
+}
+
+// Pass the turn to the next running cube after `cube`. Past the last one all
+// running cubes are waiting on the clock: advance it as far as every one of
+// them allows and start over from the first. Called with mtx_ held.
+void CubeCluster::pass_turn(int cube) {
+    const int n = size();
+    for (int j = cube + 1; j < n; ++j) {
+        if (active_[static_cast<size_t>(j)]) {
+            turn_ = j;
+            cv_.notify_all();
+            return;
+        }
+    }
+    Cycle limit = Clock::NEVER;
+    int first = -1;
+    for (int j = 0; j < n; ++j) {
+        if (!active_[static_cast<size_t>(j)]) continue;
+        limit = std::min(limit, limits_[static_cast<size_t>(j)]);
+        if (first < 0) first = j;
+    }
+    if (first >= 0) elapsed_ = clock_->advance(limit);
+    turn_ = first;
+    cv_.notify_all();
+}
+
+bool CubeCluster::run(const std::vector<GemmDesc> &gemms) {
+    if (gemms.empty() || gemms.size() > cubes_.size()) {
+        LOG_ERROR("CubeCluster::run: {} GEMMs for {} cubes", gemms.size(), cubes_.size());
+        return false;
+    }
+    const int n = static_cast<int>(gemms.size());
+    const Cycle start = clock_->now();
+    std::vector<char> ok(gemms.size(), 0);
+
+    // Cube i's control loop from its turn to the end of its run.
+    auto run_one = [this, &gemms, &ok](int i) {
+        {
+            std::unique_lock<std::mutex> lk(mtx_);
+            cv_.wait(lk, [this, i] { return turn_ == i; });
+        }
+        ok[static_cast<size_t>(i)] = cubes_[static_cast<size_t>(i)]->run_batch({gemms[static_cast<size_t>(i)]});
+        std::lock_guard<std::mutex> lk(mtx_);
+        active_[static_cast<size_t>(i)] = 0;
+        pass_turn(i);
+    };
+
+    const bool cycle_mode = std::all_of(cubes_.begin(), cubes_.end(),
+                                        [](const p_cube_t &c) { return c->get_fidelity() == Fidelity::CYCLE; });
+    if (!cycle_mode) {
+        LOG_WARN("CubeCluster::run: contention is only modelled at CYCLE fidelity; running the {} cubes one after another", n);
+        for (int i = 0; i < n; ++i) {
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+                active_[static_cast<size_t>(i)] = 1;
+                turn_ = i;
+            }
+            run_one(i);
+        }
+    } else {
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            for (int i = 0; i < n; ++i) active_[static_cast<size_t>(i)] = 1;
+            turn_ = 0;
+        }
+        std::vector<std::thread> threads;
+        for (int i = 0; i < n; ++i) threads.emplace_back(run_one, i);
+        for (auto &t : threads) t.join();
+    }
+    cycles_ = clock_->now() - start;
+
+    for (size_t i = 0; i < cubes_.size(); ++i) {
+        reports_[i] = i < gemms.size() ? report_of(*cubes_[i]) : CubeReport{};
+    }
+    return std::all_of(ok.begin(), ok.end(), [](char v) { return v != 0; });
+}
+
+CubeCluster::CubeReport CubeCluster::report_of(const Cube &cube) {
+    const SystolicArray::Stats &s = cube.get_stats();
+    const PerfModelParams p = cube.get_array()->perf_model_params();
+    const double peak = static_cast<double>(p.array_rows) * static_cast<double>(p.array_cols) *
+                        static_cast<double>(s.total_cycles);
+    CubeReport r;
+    r.cycles = s.total_cycles;
+    r.utilization = peak > 0 ? static_cast<double>(s.mac_operations) / peak : 0.0;
+    r.contention_cycles = s.memory_backpressure_cycles;
+    r.load_cycles = s.load_cycles;
+    return r;
+}
@@ -0,0 +1,78 @@
+// cube_cluster.h — 共享时钟与内存的多 Cube 簇（中文注释）
+// 簇内各 Cube 的流水线不再各自挂在时钟上：簇作为单个监听器，每个周期先推进
+// 一次共享的 Mem，再依次推进各 Cube 的流水线；起始 Cube 每周期轮转一位，
+// 排在前面的 Cube 先占用 Mem 的发射带宽与未完成窗口（逐周期轮询仲裁）。
+// 每个 Cube 的控制循环会阻塞地推进时钟，因此各跑在一个宿主线程上，但同一时刻
+// 只有一个在执行：各 Cube 按编号运行到下一次推进时钟，最后一个到达的推进一次
+// 共享时钟（步长取各自上限的最小值），再从头开始，结果与线程调度无关。
+#ifndef CUBE_CLUSTER_H
+#define CUBE_CLUSTER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "cube.h"
+#include "clock.h"
+#include "mem_if.h"
+
+class CubeCluster {
+public:
+    // `cubes` Cubes on `clock` and `mem`, built from the runtime default config.
+    CubeCluster(p_clock_t clock, p_mem_t mem, int cubes);
+    ~CubeCluster();
+
+    CubeCluster(const CubeCluster&) = delete;
+    CubeCluster& operator=(const CubeCluster&) = delete;
+
+    int size() const { return static_cast<int>(cubes_.size()); }
+    const p_cube_t &cube(int i) const { return cubes_[static_cast<size_t>(i)]; }
+
+    // 单个 Cube 在最近一次 run 中的统计
+    struct CubeReport {
+        uint64_t cycles;            // 从开始到其最后一个结果写回的周期
+        double utilization;         // mac_operations / (PE 数 * cycles)
+        uint64_t contention_cycles; // 控制循环因 Mem 拒收其请求而等待的周期（memory_backpressure_cycles）
+        uint64_t load_cycles;       // 其余等待数据的周期
+    };
+
+    // Run gemms[i] on cube i, all starting at the current cycle (cubes past
+    // the end of `gemms` stay idle); returns when every cube has finished.
+    // Contention is modelled cycle by cycle only: at other fidelities the
+    // cubes run one after another.
+    bool run(const std::vector<GemmDesc> &gemms);
+    const std::vector<CubeReport> &get_reports() const { return reports_; }
+    // Cycles from the start of the last run until its last cube finished.
+    Cycle get_cycles() const { return cycles_; }
+
+    // Report of a single cube's last run.
+    static CubeReport report_of(const Cube &cube);
+
+private:
+    p_clock_t clock_;
+    p_mem_t mem_;
+    std::vector<p_cube_t> cubes_;
+    std::size_t listener_id_;
+    size_t first_;              // pipeline ticked first in the next cycle
+
+    // Control-loop hand-over (run). active_[i]: cube i is inside its run;
+    // limits_[i]: the most cycles its pending clock wait may advance.
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::vector<char> active_;
+    std::vector<Cycle> limits_;
+    int turn_;                  // cube whose control loop may run (-1: none)
+    Cycle elapsed_;             // cycles of the last shared advance
+
+    std::vector<CubeReport> reports_;
+    Cycle cycles_;
+
+    void tick();
+    Cycle wake() const;
+    void skip(Cycle n);
+    Cycle advance(int cube, Cycle limit);
+    void pass_turn(int cube);
+};
+
+#endif // CUBE_CLUSTER_H
@@ -0,0 +1,159 @@
+#include "dma.h"
+#include "util/snapshot.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+// dma.cpp — DmaEngine 实现：描述符拆分为 Mem 请求、按通道优先级发射、完成计数。
+
+DmaEngine::DmaEngine(p_mem_t mem, int channels, int queue_depth)
+    : mem_(std::move(mem)), sink_(-1), queue_depth_(queue_depth) {
+    if (!mem_) throw std::invalid_argument("DmaEngine requires memory");
+    if (channels <= 0 || queue_depth <= 0) {
+        throw std::invalid_argument("DmaEngine: channels and queue_depth must be positive");
+    }
+    channels_.resize(static_cast<size_t>(channels));
+    sink_ = mem_->register_sink([this](uint32_t tag, size_t elems) { on_data(tag, elems); });
+}
+
+DmaEngine::~DmaEngine() {
+    mem_->unregister_sink(sink_);
+}
+
+bool DmaEngine::channel_full(int channel) const {
+    return channel < 0 || channel >= channels() || channels_[static_cast<size_t>(channel)].outstanding >= queue_depth_;
+}
+
+uint32_t DmaEngine::submit(int channel, const Descriptor &desc) {
+    if (channel_full(channel)) return 0;
+    const uint32_t id = next_id_;
+    next_id_ = next_id_ == UINT32_MAX ? 1 : next_id_ + 1;
+    const uint64_t elems = static_cast<uint64_t>(desc.count) * desc.repeat;
+    if (elems == 0) return id;
+    Channel &ch = channels_[static_cast<size_t>(channel)];
+    ch.queue.push_back(Transfer{id, desc, 0, 0});
+    ch.outstanding++;
+    inflight_.emplace(id, InFlight{channel, elems, elems, Mem::BankStats{0, 0, 0}});
+    // issue in the submitting cycle, as the controller would have itself
+    issue();
+    return id;
+}
+
+// Channels are served in index order; within a channel, transfers go out in
+// submission order. A rejection means Mem takes no further reads this cycle
+// (issue budget or outstanding window), so issuing stops there.
+void DmaEngine::issue() {
+    for (auto &ch : channels_) {
+        while (!ch.queue.empty()) {
+            Transfer &t = ch.queue.front();
+            const Descriptor &d = t.desc;
+            Mem::ReadDescriptor rd;
+            rd.sink = sink_;
+            rd.tag = t.id;
+            uint32_t n = 0;
+            if (d.burst == 0) {
+                rd.base = d.src;
+                rd.count = d.count;
+                rd.stride = d.stride;
+                rd.repeat = d.repeat;
+                rd.stream = d.stream;
+                rd.stream_row_step = d.stream_row_step;
+                rd.stream_col_step = d.stream_col_step;
+            } else {
+                n = std::min(d.burst, d.count - t.next_col);
+                rd.base = d.src + static_cast<Addr>(t.next_row) * d.stride + t.next_col;
+                rd.count = n;
+                rd.stride = n;
+                rd.repeat = 1;
+                rd.stream = d.stream + static_cast<int>(t.next_row) * d.stream_row_step +
+                            static_cast<int>(t.next_col) * d.stream_col_step;
+                rd.stream_col_step = d.stream_col_step;
+            }
+            const Mem::BankStats before = mem_->get_bank_stats();
+            if (!mem_->read_request(rd)) return;
+            if (mem_->banked()) {
+                const Mem::BankStats &after = mem_->get_bank_stats();
+                Mem::BankStats &bank = inflight_.at(t.id).bank;
+                bank.row_hits += after.row_hits - before.row_hits;
+                bank.row_misses += after.row_misses - before.row_misses;
+                bank.conflict_cycles += after.conflict_cycles - before.conflict_cycles;
+            }
+            ch.stats.requests++;
+            bool issued = d.burst == 0;
+            if (!issued) {
+                t.next_col += n;
+                if (t.next_col == d.count) {
+                    t.next_col = 0;
+                    issued = ++t.next_row == d.repeat;
+                }
+            }
+            if (issued) ch.queue.pop_front();
+        }
+    }
+}
+
+bool DmaEngine::has_unissued() const {
+    for (const auto &ch : channels_) if (!ch.queue.empty()) return true;
+    return false;
+}
+
+void DmaEngine::on_data(uint32_t id, size_t elems) {
+    auto it = inflight_.find(id);
+    if (it == inflight_.end()) return;
+    Channel &ch = channels_[static_cast<size_t>(it->second.channel)];
+    ch.stats.elements += elems;
+    it->second.remaining -= std::min<uint64_t>(elems, it->second.remaining);
+    if (it->second.remaining != 0) return;
+    const Completion done{it->second.channel, id, it->second.elements, it->second.bank};
+    inflight_.erase(it);
+    ch.outstanding--;
+    ch.stats.transfers++;
+    if (on_complete_) on_complete_(done);
+}
+
+void DmaEngine::cycle() {
+    if (!has_unissued()) return;
+    stall_cycles_++;
+    issue();
+}
+
+Cycle DmaEngine::cycles_until_event() const {
+    // A full outstanding window frees up on a Mem completion, which wakes the clock anyway.
+    return !has_unissued() || mem_->outstanding_full() ? UINT64_MAX : 1;
+}
+
+void DmaEngine::skip(Cycle n) {
+    if (has_unissued()) stall_cycles_ += n;
+}
+
+void DmaEngine::save(util::SnapshotWriter &w) const {
+    w.tag("DMA ");
+    w.put(next_id_);
+    w.put(stall_cycles_);
+    w.put<uint64_t>(channels_.size());
+    for (const auto &ch : channels_) {
+        w.put(ch.outstanding);
+        w.put(ch.stats);
+        w.put_vec(std::vector<Transfer>(ch.queue.begin(), ch.queue.end()));
+    }
+    std::vector<InFlightImage> inflight;
+    for (const auto &kv : inflight_) inflight.push_back(InFlightImage{kv.first, kv.second});
+    w.put_vec(inflight);
+}
+
+bool DmaEngine::load(util::SnapshotReader &r) {
+    uint64_t n = 0;
+    if (!r.expect_tag("DMA ") || !r.get(next_id_) || !r.get(stall_cycles_) || !r.get(n) || n != channels_.size()) {
+        return false;
+    }
+    for (auto &ch : channels_) {
+        std::vector<Transfer> queue;
+        if (!r.get(ch.outstanding) || !r.get(ch.stats) || !r.get_vec(queue)) return false;
+        ch.queue.assign(queue.begin(), queue.end());
+    }
+    std::vector<InFlightImage> inflight;
+    if (!r.get_vec(inflight)) return false;
+    inflight_.clear();
+    for (const auto &img : inflight) inflight_.emplace(img.id, img.state);
+    return true;
+}
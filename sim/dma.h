@@ -0,0 +1,124 @@
+// dma.h — 多通道异步 DMA 引擎（中文注释）
+// 控制器把传输描述符（源地址、目标流、形状、跨步）放入某个通道的队列后即可
+// 继续执行；引擎作为时钟驱动的流水线阶段，每个周期按通道优先级（编号小者
+// 优先）把队首描述符拆成 Mem 请求发出，被 Mem 拒绝（发射带宽或未完成窗口
+// 用尽）时留到下一周期重试。数据经 Mem 的完成通知（sink）计数，一个传输
+// 的全部元素落入目标 FIFO 后触发完成事件。
+#ifndef DMA_ENGINE_H
+#define DMA_ENGINE_H
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <vector>
+
+#include "types.h"
+#include "mem_if.h"
+
+namespace util { class SnapshotWriter; class SnapshotReader; }
+
+class DmaEngine {
+public:
+    // `repeat` rows of `count` elements, row starts `stride` apart, read from
+    // `src`; element (r, c) lands in stream + r * stream_row_step + c * stream_col_step.
+    // `burst` is the longest Mem request along a row; 0 sends the whole block
+    // as one 2D request.
+    struct Descriptor {
+        Addr src = 0;
+        uint32_t count = 0;
+        Addr stride = 0;
+        uint32_t repeat = 1;
+        int stream = -1;
+        int stream_row_step = 0;
+        int stream_col_step = 0;
+        uint32_t burst = 0;
+    };
+
+    struct ChannelStats {
+        uint64_t transfers;     // completed transfers
+        uint64_t requests;      // Mem requests issued
+        uint64_t elements;      // elements delivered
+    };
+
+    // Completion event of one transfer.
+    struct Completion {
+        int channel;
+        uint32_t id;
+        uint64_t elements;
+        Mem::BankStats bank;    // bank activity of its requests (memory.banked)
+    };
+    // Called once per completed transfer, from inside Mem::cycle().
+    using CompletionHandler = std::function<void(const Completion &)>;
+
+    // `queue_depth` bounds the transfers a channel holds (queued or in
+    // flight). Throws std::invalid_argument without memory or with
+    // non-positive sizes.
+    DmaEngine(p_mem_t mem, int channels, int queue_depth);
+    ~DmaEngine();
+    DmaEngine(const DmaEngine&) = delete;
+    DmaEngine& operator=(const DmaEngine&) = delete;
+
+    // Queue a transfer; it starts issuing right away if Mem accepts. Returns
+    // its id, or 0 when the channel is full (or does not exist).
+    uint32_t submit(int channel, const Descriptor &desc);
+    void set_completion_handler(CompletionHandler handler) { on_complete_ = std::move(handler); }
+
+    // Clock stage interface: issue pending requests, cycles until issuing
+    // can make progress (UINT64_MAX when only a Mem completion can help),
+    // and bulk accounting of skipped cycles.
+    void cycle();
+    Cycle cycles_until_event() const;
+    void skip(Cycle n);
+
+    bool idle() const { return inflight_.empty(); }
+    bool done(uint32_t id) const { return inflight_.count(id) == 0; }
+    bool channel_full(int channel) const;
+    int channels() const { return static_cast<int>(channels_.size()); }
+    const ChannelStats &channel_stats(int channel) const { return channels_[static_cast<size_t>(channel)].stats; }
+    // Cycles that began with requests waiting for Mem to accept them.
+    uint64_t stall_cycles() const { return stall_cycles_; }
+
+    // Checkpoint support. The engine must be constructed (and so register
+    // its Mem sink) in the same order as when the snapshot was written.
+    void save(util::SnapshotWriter &w) const;
+    bool load(util::SnapshotReader &r);
+
+private:
+    struct Transfer {
+        uint32_t id;
+        Descriptor desc;
+        uint32_t next_row;  // issue position
+        uint32_t next_col;
+    };
+    struct Channel {
+        std::deque<Transfer> queue;   // not fully issued yet; the head is in progress
+        int outstanding = 0;          // transfers not yet complete
+        ChannelStats stats{};
+    };
+    struct InFlight {
+        int channel;
+        uint64_t elements;
+        uint64_t remaining;           // elements still to land
+        Mem::BankStats bank;
+    };
+    struct InFlightImage {
+        uint32_t id;
+        InFlight state;
+    };
+
+    void issue();
+    bool has_unissued() const;
+    void on_data(uint32_t id, size_t elems);
+
+    p_mem_t mem_;
+    int sink_;
+    int queue_depth_;
+    std::vector<Channel> channels_;
+    std::map<uint32_t, InFlight> inflight_;
+    uint32_t next_id_ = 1;
+    uint64_t stall_cycles_ = 0;
+    CompletionHandler on_complete_;
+};
+
+#endif // DMA_ENGINE_H
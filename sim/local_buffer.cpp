@@ -0,0 +1,93 @@
+#include "local_buffer.h"
+#include "util/snapshot.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+// local_buffer.cpp — LocalBuffer 实现：tile 粒度的分配 / 替换与读端口时序。
+
+LocalBuffer::LocalBuffer(size_t capacity, int ports, int port_width, int latency, BufferPolicy policy)
+    : capacity_(capacity), ports_(ports), port_width_(port_width), latency_(latency), policy_(policy) {
+    if (capacity_ == 0 || ports_ <= 0 || port_width_ <= 0 || latency_ < 0) {
+        throw std::invalid_argument("LocalBuffer: capacity, ports and port_width must be positive");
+    }
+}
+
+const std::vector<DataType> *LocalBuffer::lookup(const Key &key) {
+    auto it = lines_.find(key);
+    if (it == lines_.end()) return nullptr;
+    lru_.splice(lru_.begin(), lru_, it->second.lru);
+    return &it->second.data;
+}
+
+bool LocalBuffer::insert(const Key &key, std::vector<DataType> &&data) {
+    if (lines_.count(key) || data.size() > capacity_) return false;
+    if (policy_ == BufferPolicy::LRU) {
+        while (used_ + data.size() > capacity_) {
+            erase(lines_.find(lru_.back()));
+            evictions_++;
+        }
+    } else if (used_ + data.size() > capacity_) {
+        return false;
+    }
+    used_ += data.size();
+    lru_.push_front(key);
+    lines_.emplace(key, Line{std::move(data), lru_.begin()});
+    return true;
+}
+
+void LocalBuffer::release(Operand operand) {
+    for (auto it = lines_.begin(); it != lines_.end(); ) {
+        auto next = std::next(it);
+        if (it->first.operand == operand) erase(it);
+        it = next;
+    }
+}
+
+void LocalBuffer::clear() {
+    lines_.clear();
+    lru_.clear();
+    used_ = 0;
+    next_free_ = 0;
+}
+
+void LocalBuffer::erase(std::map<Key, Line>::iterator it) {
+    used_ -= it->second.data.size();
+    lru_.erase(it->second.lru);
+    lines_.erase(it);
+}
+
+Cycle LocalBuffer::transfer(Cycle now, size_t elems) {
+    const size_t per_cycle = static_cast<size_t>(ports_) * static_cast<size_t>(port_width_);
+    const Cycle beats = static_cast<Cycle>((elems + per_cycle - 1) / per_cycle);
+    const Cycle start = std::max(now, next_free_);
+    next_free_ = start + beats;
+    return next_free_ + static_cast<Cycle>(latency_);
+}
+
+void LocalBuffer::save(util::SnapshotWriter &w) const {
+    w.tag("LBUF");
+    w.put(next_free_);
+    w.put(evictions_);
+    w.put<uint64_t>(lru_.size());
+    // least recent first, so that re-inserting restores the order
+    for (auto it = lru_.rbegin(); it != lru_.rend(); ++it) {
+        w.put(*it);
+        w.put_vec(lines_.at(*it).data);
+    }
+}
+
+bool LocalBuffer::load(util::SnapshotReader &r) {
+    clear();
+    uint64_t n = 0;
+    if (!r.expect_tag("LBUF") || !r.get(next_free_) || !r.get(evictions_) || !r.get(n)) return false;
+    for (uint64_t i = 0; i < n; ++i) {
+        Key key;
+        std::vector<DataType> data;
+        if (!r.get(key) || !r.get_vec(data)) return false;
+        used_ += data.size();
+        lru_.push_front(key);
+        lines_.emplace(key, Line{std::move(data), lru_.begin()});
+    }
+    return true;
+}
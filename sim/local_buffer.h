@@ -0,0 +1,84 @@
+// local_buffer.h — 片上本地缓冲（L1/L0）模型（中文注释）
+// 位于 Mem 与阵列边缘 FIFO 之间，按 tile 缓存 A 行块 / B 子块。命中的 tile
+// 不再访问主存，由本地缓冲的读端口送入 FIFO；缺失的 tile 从 Mem 取回后
+// 顺带写入缓冲。容量按元素计，替换策略为 LRU 或显式分配（EXPLICIT：
+// 不驱逐，由使用方在数据不再复用时整体释放某一操作数的 tile）。
+#ifndef LOCAL_BUFFER_H
+#define LOCAL_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <tuple>
+#include <vector>
+
+#include "types.h"
+
+namespace util { class SnapshotWriter; class SnapshotReader; }
+
+class LocalBuffer {
+public:
+    enum Operand : uint8_t { kOperandA = 0, kOperandB = 1 };
+
+    // A cached tile: `rows` x `cols` elements of one operand starting at
+    // `base`, rows `stride` elements apart in memory.
+    struct Key {
+        uint8_t operand;
+        Addr base;
+        uint32_t rows;
+        uint32_t cols;
+        Addr stride;
+        bool operator<(const Key &o) const {
+            return std::tie(operand, base, rows, cols, stride) < std::tie(o.operand, o.base, o.rows, o.cols, o.stride);
+        }
+    };
+
+    // `capacity` in elements; each of `ports` read ports moves `port_width`
+    // elements per cycle, and a transfer becomes visible `latency` cycles
+    // after its last beat. Throws std::invalid_argument on non-positive sizes.
+    LocalBuffer(size_t capacity, int ports, int port_width, int latency, BufferPolicy policy);
+
+    // Resident tile data (row-major) or nullptr; a hit refreshes LRU order.
+    const std::vector<DataType> *lookup(const Key &key);
+    // Allocate a tile. LRU evicts the least recently used tiles to make
+    // room; EXPLICIT never evicts. False (tile bypasses the buffer) when it
+    // cannot be placed.
+    bool insert(const Key &key, std::vector<DataType> &&data);
+    // Free every tile of `operand` (explicit allocation: its reuse ended).
+    void release(Operand operand);
+    void clear();
+
+    // Reserve the read ports for `elems` elements starting no earlier than
+    // `now`; returns the cycle at which the data is available in the FIFOs.
+    Cycle transfer(Cycle now, size_t elems);
+
+    BufferPolicy policy() const { return policy_; }
+    size_t capacity() const { return capacity_; }
+    size_t used() const { return used_; }
+    uint64_t evictions() const { return evictions_; }
+
+    // Checkpoint support: resident tiles in LRU order plus port state.
+    void save(util::SnapshotWriter &w) const;
+    bool load(util::SnapshotReader &r);
+
+private:
+    struct Line {
+        std::vector<DataType> data;
+        std::list<Key>::iterator lru; // position in lru_ (front = most recent)
+    };
+    void erase(std::map<Key, Line>::iterator it);
+
+    size_t capacity_;
+    int ports_;
+    int port_width_;
+    int latency_;
+    BufferPolicy policy_;
+    std::map<Key, Line> lines_;
+    std::list<Key> lru_;
+    size_t used_ = 0;
+    Cycle next_free_ = 0;   // first cycle the read ports are free again
+    uint64_t evictions_ = 0;
+};
+
+#endif // LOCAL_BUFFER_H
@@ -1,9 +1,17 @@
 #include "mem_if.h"
+#include "mem_trace.h"
 #include "config/config.h"
+#include "util/log.h"
+#include "util/snapshot.h"
 
+#include <algorithm>
 #include <cstddef>
 #include <memory>
 
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 // mem_if.cpp — 内存模型实现（中文注释）
 // 实现 `Mem` 类的异步读/写请求队列、按周期推进的完成逻辑以及数据加载方法。
 // 该实现模拟带宽与延迟、突发读写并为上层提供完成队列回调风格的接口。
@@ -13,11 +21,18 @@ Mem::Mem(p_clock_t clock)
           max_outstanding_(0),
           issue_bw_read_(4), issue_bw_write_(4),
           complete_bw_read_(4), complete_bw_write_(4),
-          current_cycle_(0), issued_read_this_cycle_(0), issued_write_this_cycle_(0) {
+          current_cycle_(0), issued_read_this_cycle_(0), issued_write_this_cycle_(0),
+          wheel_mask_(0), pending_count_(0), waiting_count_(0), ready_writes_(0), next_seq_(0),
+          banked_(false), bank_count_(1), bank_interleave_(1), bank_row_size_(1),
+          row_hit_latency_(10), row_miss_latency_(10), bank_stats_{0, 0, 0},
+          coalesce_window_(0), coalesce_slot_(0), coalesce_seq_(0), coalesce_opened_(0),
+          coalesce_valid_(false), coalesce_grown_(false), coalesce_stats_{0, 0, 0} {
     // Centralize configuration reads
     config();
 }
 
+Mem::~Mem() = default;
+
 void Mem::config() {
     // Configuration is read via the runtime default path (set with config::set_default_path).
     std::string path = config::get_default_path();
@@ -37,48 +52,318 @@ void Mem::config() {
         max_outstanding_ = complete_bw_read_ * latency_;
     }
 
-    // memory size: default to 64 elements (previously 64 KB interpreted as elements)
-    int size_kb = get<int>("memory.size_kb").value_or(64);
-    memory_.resize(size_kb);
+    // memory size: default to 64 elements (previously 64 KB interpreted as elements).
+    // Only the extent is set; pages are allocated when first written.
+    int64_t size_kb = get<int64_t>("memory.size_kb").value_or(64);
+    memory_.clear();
+    acc_memory_.clear();
+    const bool page_mmap = get<bool>("memory.page_mmap").value_or(false);
+    memory_.set_use_mmap(page_mmap);
+    acc_memory_.set_use_mmap(page_mmap);
+    memory_.resize(static_cast<uint64_t>(std::max<int64_t>(0, size_kb)));
 
     // ensure accumulator memory is at least the same size (one-to-one mapping)
     acc_memory_.resize(memory_.size());
+
+    // 分 bank 模型（默认关闭，关闭时所有请求固定 latency_）
+    banked_ = get<bool>("memory.banked").value_or(false);
+    bank_count_ = std::max(1, get<int>("memory.banks").value_or(8));
+    bank_interleave_ = std::max(1, get<int>("memory.bank_interleave").value_or(8));
+    bank_row_size_ = std::max(1, get<int>("memory.row_size").value_or(512));
+    row_hit_latency_ = std::max(0, get<int>("memory.row_hit_latency").value_or(latency_));
+    row_miss_latency_ = std::max(row_hit_latency_, get<int>("memory.row_miss_latency").value_or(latency_ + 8));
+
+    // 读合并（默认关闭）。分 bank 模型在发射时按地址确定时序，合并后无法重算，故不合并。
+    coalesce_window_ = get<bool>("memory.coalesce").value_or(false) && !banked_
+                           ? std::max(1, get<int>("memory.coalesce_window").value_or(8)) : 0;
+
+    reset_queue();
+
+    // 访问轨迹（空：不记录）
+    const std::string trace_file = get<std::string>("memory.trace_file").value_or("");
+    if (!trace_file.empty()) start_trace(trace_file);
+}
+
+// Every request becomes ready latency_ + 1 cycles after issue, so one wheel
+// turn longer than that keeps each bucket to a single due cycle in practice.
+// Banked requests can also queue behind a busy bank; those whole turns ahead
+// are still found by cycles_until_event()'s fallback scan.
+void Mem::reset_queue() {
+    const int longest = banked_ ? std::max(latency_, row_miss_latency_) : latency_;
+    uint64_t size = 1;
+    while (size < static_cast<uint64_t>(longest) + 2) size <<= 1;
+    wheel_.assign(static_cast<size_t>(size), {});
+    wheel_mask_ = size - 1;
+    slots_.clear();
+    free_slots_.clear();
+    ready_.clear();
+    pending_count_ = waiting_count_ = ready_writes_ = 0;
+    next_seq_ = 0;
+    banks_.assign(banked_ ? static_cast<size_t>(bank_count_) : 0, Bank{-1, 0});
+    bank_stats_ = {0, 0, 0};
+    coalesce_valid_ = false;
+    coalesce_stats_ = {0, 0, 0};
 }
 
+// One access of `len` consecutive elements inside a single interleave chunk,
+// starting no earlier than `start`. A row miss first opens the row (the
+// bank is busy for the extra miss latency), then one element per cycle
+// streams out of the row buffer. Returns the cycle the last element is out.
+uint64_t Mem::bank_access(Addr addr, uint32_t len, uint64_t start) {
+    const uint64_t chunk = addr / static_cast<uint64_t>(bank_interleave_);
+    Bank &b = banks_[static_cast<size_t>(chunk % static_cast<uint64_t>(bank_count_))];
+    const uint64_t local = (chunk / static_cast<uint64_t>(bank_count_)) * static_cast<uint64_t>(bank_interleave_) +
+                           addr % static_cast<uint64_t>(bank_interleave_);
+    const int64_t row = static_cast<int64_t>(local / static_cast<uint64_t>(bank_row_size_));
+    const uint64_t begin = std::max(start, b.next_free);
+    bank_stats_.conflict_cycles += begin - start;
+    int lat = row_hit_latency_;
+    if (b.open_row == row) {
+        bank_stats_.row_hits++;
+    } else {
+        bank_stats_.row_misses++;
+        lat = row_miss_latency_;
+        b.open_row = row;
+    }
+    b.next_free = begin + static_cast<uint64_t>(lat - row_hit_latency_) + len;
+    return begin + static_cast<uint64_t>(lat) + len - 1;
+}
 
+// Split a request into per-bank chunks and resolve when its last element is
+// out; ready one cycle later, as with the flat latency_ (hit, one element).
+uint64_t Mem::banked_ready_cycle(const Request &req) {
+    const Addr il = static_cast<Addr>(bank_interleave_);
+    const Addr rows = req.len / req.count;
+    uint64_t done = current_cycle_;
+    for (Addr r = 0; r < rows; ++r) {
+        Addr addr = req.addr + r * req.stride;
+        uint32_t left = req.count;
+        while (left > 0) {
+            uint32_t n = static_cast<uint32_t>(std::min<Addr>(left, il - addr % il));
+            done = std::max(done, bank_access(addr, n, current_cycle_));
+            addr += n;
+            left -= n;
+        }
+    }
+    return done + 1;
+}
 
-bool Mem::read_request(uint32_t addr, std::shared_ptr<std::deque<DataType>> completion_queue, size_t max_queue_depth, size_t len) {
+uint32_t Mem::enqueue(Request &&req) {
+    req.seq = next_seq_++;
+    uint32_t slot;
+    if (!free_slots_.empty()) {
+        slot = free_slots_.back();
+        free_slots_.pop_back();
+        slots_[slot] = std::move(req);
+    } else {
+        slot = static_cast<uint32_t>(slots_.size());
+        slots_.push_back(std::move(req));
+    }
+    wheel_[static_cast<size_t>(slots_[slot].ready_cycle & wheel_mask_)].push_back(slot);
+    pending_count_++;
+    waiting_count_++;
+    coalesce_stats_.peak_pending = std::max<uint64_t>(coalesce_stats_.peak_pending, pending_count_);
+    return slot;
+}
+
+// Move due requests into ready_, keeping ready_ sorted by issue order.
+void Mem::make_ready(std::vector<uint32_t> &due) {
+    auto by_seq = [this](uint32_t a, uint32_t b) { return slots_[a].seq < slots_[b].seq; };
+    std::sort(due.begin(), due.end(), by_seq);
+    for (uint32_t slot : due) {
+        if (slots_[slot].is_write) ready_writes_++;
+        // Equal latencies make this an append; only mixed latencies insert.
+        if (ready_.empty() || by_seq(ready_.back(), slot)) {
+            ready_.push_back(slot);
+        } else {
+            ready_.insert(std::upper_bound(ready_.begin(), ready_.end(), slot, by_seq), slot);
+        }
+    }
+    waiting_count_ -= due.size();
+    due.clear();
+}
+
+
+
+int Mem::register_stream(FIFO *fifo) {
+    streams_.push_back(fifo);
+    return static_cast<int>(streams_.size()) - 1;
+}
+
+void Mem::unregister_stream(int stream) {
+    if (stream >= 0 && stream < static_cast<int>(streams_.size())) streams_[static_cast<size_t>(stream)] = nullptr;
+}
+
+void Mem::extend(Addr size) {
+    if (memory_.size() < size) memory_.resize(size);
+    if (acc_memory_.size() < size) acc_memory_.resize(size);
+}
+
+bool Mem::start_trace(const std::string &path) {
+    std::unique_ptr<MemTraceWriter> w(new MemTraceWriter(path));
+    if (!w->good()) {
+        LOG_ERROR("Mem: cannot open trace file {}", path);
+        return false;
+    }
+    trace_ = std::move(w);
+    return true;
+}
+
+void Mem::stop_trace() {
+    trace_.reset();
+}
+
+int Mem::register_sink(CompletionSink sink) {
+    sinks_.push_back(std::move(sink));
+    return static_cast<int>(sinks_.size()) - 1;
+}
+
+void Mem::unregister_sink(int sink) {
+    if (sink >= 0 && sink < static_cast<int>(sinks_.size())) sinks_[static_cast<size_t>(sink)] = nullptr;
+}
+
+bool Mem::read_request(Addr addr, int stream, size_t len) {
+    ReadDescriptor desc;
+    desc.base = addr;
+    desc.count = static_cast<uint32_t>(len);
+    desc.stride = static_cast<Addr>(len);
+    desc.repeat = 1;
+    desc.stream = stream;
     if (addr >= memory_.size()) return false;
+    return read_request(desc);
+}
+
+// Append a single-row read to the open read if it continues it: the next
+// address, landing where the open read's destination pattern continues
+// (same stream, or the next streams with the same col_step), with the
+// same completion sink and tag. The burst is ready when its last part
+// would have been, so no element arrives before its own latency.
+bool Mem::coalesce_read(const ReadDescriptor &desc) {
+    if (!coalesce_valid_ || desc.repeat != 1) return false;
+    Request &open = slots_[coalesce_slot_];
+    if (open.seq != coalesce_seq_ || open.ready_cycle <= current_cycle_ ||
+        current_cycle_ - coalesce_opened_ >= static_cast<uint64_t>(coalesce_window_)) {
+        coalesce_valid_ = false;
+        return false;
+    }
+    if (open.len != open.count || open.sink != desc.sink || open.tag != desc.tag || open.row_step != 0 ||
+        desc.base != open.addr + open.count || desc.stream < 0 || open.stream < 0) {
+        return false;
+    }
+    // destination step of the merged row: fixed by the open read unless it is a single element
+    const int step = open.count == 1 ? (desc.stream - open.stream) : open.col_step;
+    if (desc.stream != open.stream + static_cast<int>(open.count) * step) return false;
+    if (desc.count > 1 && desc.stream_col_step != step) return false;
+
+    const uint64_t ready = current_cycle_ + static_cast<uint64_t>(latency_) + 1;
+    if (ready != open.ready_cycle) {
+        auto &from = wheel_[static_cast<size_t>(open.ready_cycle & wheel_mask_)];
+        from.erase(std::find(from.begin(), from.end(), coalesce_slot_));
+        wheel_[static_cast<size_t>(ready & wheel_mask_)].push_back(coalesce_slot_);
+        open.ready_cycle = ready;
+    }
+    if (!coalesce_grown_) coalesce_stats_.bursts++;
+    coalesce_grown_ = true;
+    open.col_step = step;
+    open.count += desc.count;
+    open.stride = open.count;
+    open.len = open.count;
+    coalesce_stats_.merged_reads++;
+    return true;
+}
+
+bool Mem::read_request(const ReadDescriptor &desc) {
+    const size_t len = static_cast<size_t>(desc.count) * desc.repeat;
     if (len == 0) return true;
-    if (static_cast<int>(pending_requests_.size()) >= max_outstanding_) return false;
+    const Addr last = desc.base + static_cast<Addr>(desc.repeat - 1) * desc.stride + desc.count - 1;
+    if (last >= memory_.size()) return false;
+    if (coalesce_window_ > 0 && coalesce_read(desc)) {
+        if (trace_) trace_->record(MemTraceRecord{current_cycle_, MemTraceOp::READ, desc.base, len, desc.count, desc.stride, 1});
+        return true;
+    }
+    if (static_cast<int>(pending_count_) >= max_outstanding_) return false;
     if (issued_read_this_cycle_ >= issue_bw_read_) return false;
     Request req;
-    req.addr = addr;
-    req.completion_queue = completion_queue;
-    req.max_queue_depth = max_queue_depth;
+    req.addr = desc.base;
+    req.stream = desc.stream;
     req.is_write = false;
-    req.remaining_cycles = latency_;
+    req.write_data = 0;
+    req.ready_cycle = current_cycle_ + static_cast<uint64_t>(latency_) + 1;
     req.len = len;
     req.progress = 0;
-    pending_requests_.push_back(req);
+    req.count = desc.count;
+    req.stride = desc.stride;
+    req.row_step = desc.stream_row_step;
+    req.col_step = desc.stream_col_step;
+    req.sink = desc.sink;
+    req.tag = desc.tag;
+    if (banked_) req.ready_cycle = banked_ready_cycle(req);
+    if (trace_) {
+        trace_->record(MemTraceRecord{current_cycle_, desc.repeat == 1 ? MemTraceOp::READ : MemTraceOp::READ_2D,
+                                      desc.base, len, desc.count, desc.stride, desc.repeat});
+    }
+    const uint32_t slot = enqueue(std::move(req));
     issued_read_this_cycle_++;
+    if (coalesce_window_ > 0) {
+        coalesce_slot_ = slot;
+        coalesce_seq_ = slots_[slot].seq;
+        coalesce_opened_ = current_cycle_;
+        coalesce_valid_ = true;
+        coalesce_grown_ = false;
+    }
     return true;
 }
 
-bool Mem::write_request(uint32_t addr, DataType data) {
+bool Mem::write_request(Addr addr, DataType data) {
     if (addr >= memory_.size()) return false;
-    if (static_cast<int>(pending_requests_.size()) >= max_outstanding_) return false;
+    if (static_cast<int>(pending_count_) >= max_outstanding_) return false;
     if (issued_write_this_cycle_ >= issue_bw_write_) return false;
     Request req;
     req.addr = addr;
-    req.completion_queue = std::shared_ptr<std::deque<DataType>>();
-    req.max_queue_depth = 0;
+    req.stream = -1;
     req.is_write = true;
     req.write_data = data;
-    req.remaining_cycles = latency_;
+    req.ready_cycle = current_cycle_ + static_cast<uint64_t>(latency_) + 1;
     req.len = 1;
     req.progress = 0;
-    pending_requests_.push_back(req);
+    req.count = 1;
+    req.stride = 1;
+    req.row_step = 0;
+    req.col_step = 0;
+    req.sink = -1;
+    req.tag = 0;
+    if (banked_) req.ready_cycle = banked_ready_cycle(req);
+    if (trace_) trace_->record(MemTraceRecord{current_cycle_, MemTraceOp::WRITE, addr, 1, 1, 1, 1});
+    enqueue(std::move(req));
+    issued_write_this_cycle_++;
+    return true;
+}
+
+// Accumulator write-back goes to its own region, which is not banked.
+bool Mem::acc_write_request(Addr addr, const AccType *vals, size_t len, int sink, uint32_t tag) {
+    if (len == 0) return true;
+    if (static_cast<int>(pending_count_) >= max_outstanding_) return false;
+    if (issued_write_this_cycle_ >= issue_bw_write_) return false;
+    Request req;
+    req.addr = addr;
+    req.stream = -1;
+    req.is_write = true;
+    req.write_data = 0;
+    req.ready_cycle = current_cycle_ + static_cast<uint64_t>(latency_) + 1;
+    req.len = len;
+    req.progress = 0;
+    req.count = static_cast<uint32_t>(len);
+    req.stride = len;
+    req.row_step = 0;
+    req.col_step = 0;
+    req.sink = sink;
+    req.tag = tag;
+    req.acc_data.assign(vals, vals + len);
+    if (trace_) {
+        trace_->record(MemTraceRecord{current_cycle_, MemTraceOp::ACC_WRITE, addr, len,
+                                      static_cast<uint32_t>(len), len, 1});
+    }
+    enqueue(std::move(req));
     issued_write_this_cycle_++;
     return true;
 }
@@ -88,74 +373,170 @@ void Mem::cycle() {
     issued_read_this_cycle_ = 0;
     issued_write_this_cycle_ = 0;
 
-    // 遍历 pending_requests，减少 remaining_cycles；当到达 0 时尝试完成请求（受带宽限制）
-    int completed_read = 0;
-    int completed_write = 0;
-    for (auto it = pending_requests_.begin(); it != pending_requests_.end(); ) {
-        if (it->remaining_cycles > 0) {
-            it->remaining_cycles--;
-            ++it;
-            continue;
-        }
-
-        if (it->is_write) {
-            if (completed_write >= complete_bw_write_) { ++it; continue; }
-            memory_[it->addr] = it->write_data;
-            it = pending_requests_.erase(it);
-            completed_write++;
-            continue;
+    // 当前周期的轮槽：到期的请求进入 ready_（整圈之后的请求留在槽中）
+    auto &bucket = wheel_[static_cast<size_t>(current_cycle_ & wheel_mask_)];
+    if (!bucket.empty()) {
+        std::vector<uint32_t> due;
+        size_t keep = 0;
+        for (uint32_t slot : bucket) {
+            if (slots_[slot].ready_cycle <= current_cycle_) due.push_back(slot);
+            else bucket[keep++] = slot;
         }
+        bucket.resize(keep);
+        if (!due.empty()) make_ready(due);
+    }
 
-        // 读请求完成：尝试按 burst 推送数据到 completion_queue
-        if (completed_read >= complete_bw_read_) { ++it; continue; }
+    // 按发射顺序完成就绪请求（受完成带宽限制）；两种带宽都用完即停止扫描
+    int completed_read = 0;
+    int completed_write = 0;
+    size_t writes_left = ready_writes_;
+    size_t reads_left = ready_.size() - ready_writes_;
+    size_t kept = 0, i = 0;
+    for (; i < ready_.size(); ++i) {
+        bool reads_done = completed_read >= complete_bw_read_ || reads_left == 0;
+        bool writes_done = completed_write >= complete_bw_write_ || writes_left == 0;
+        if (reads_done && writes_done) break;
 
-        auto q = it->completion_queue;
-        if (!q) {
-            it = pending_requests_.erase(it);
-            completed_read++;
-            continue;
+        uint32_t slot = ready_[i];
+        Request &req = slots_[slot];
+        bool finished = false;
+        if (req.is_write) {
+            writes_left--;
+            if (completed_write < complete_bw_write_) {
+                if (req.acc_data.empty()) {
+                    memory_.at(req.addr) = req.write_data;
+                    completed_write++;
+                    finished = true;
+                } else {
+                    // accumulator burst: as many elements as the write budget allows
+                    size_t n = std::min(static_cast<size_t>(complete_bw_write_ - completed_write), req.len - req.progress);
+                    for (size_t e = 0; e < n; ++e) {
+                        acc_memory_.at(req.addr + req.progress + e) += req.acc_data[req.progress + e];
+                    }
+                    req.progress += n;
+                    completed_write += static_cast<int>(n);
+                    finished = req.progress >= req.len;
+                    if (n) notify(req, n);
+                }
+                if (finished) ready_writes_--;
+            }
+        } else {
+            reads_left--;
+            if (completed_read < complete_bw_read_) {
+                // 读请求完成：按行优先顺序直接写入各元素目标流的 FIFO
+                if (req.row_step == 0 && req.col_step == 0 && !stream_fifo(req.stream)) {
+                    // no destination: the data is dropped in a single completion slot
+                    completed_read++;
+                    finished = true;
+                    notify(req, req.len - req.progress);
+                } else {
+                    size_t remaining_len = req.len - req.progress;
+                    size_t can_complete = std::min(static_cast<size_t>(complete_bw_read_ - completed_read), remaining_len);
+                    size_t row = req.progress / req.count;
+                    size_t col = req.progress % req.count;
+                    const bool one_stream = req.row_step == 0 && req.col_step == 0;
+                    size_t pushed = 0;
+                    while (pushed < can_complete) {
+                        // one page-contiguous piece of the current row
+                        size_t n = std::min(can_complete - pushed, static_cast<size_t>(req.count) - col);
+                        const DataType *src = memory_.run(req.addr + row * req.stride + col, n);
+                        size_t done = 0;
+                        if (one_stream) {
+                            FIFO *dst = stream_fifo(req.stream);
+                            if (src) {
+                                while (done < n && !dst->full()) dst->push(src[done++]);
+                            } else {
+                                for (; done < n && !dst->full(); ++done) dst->push(DataType{});
+                            }
+                        } else {
+                            for (; done < n; ++done) {
+                                FIFO *dst = stream_fifo(req.stream + static_cast<int>(row) * req.row_step +
+                                                        static_cast<int>(col + done) * req.col_step);
+                                if (dst && dst->full()) break;
+                                if (dst) dst->push(src ? src[done] : DataType{});
+                            }
+                        }
+                        pushed += done;
+                        col += done;
+                        if (col == req.count) { col = 0; ++row; }
+                        if (done < n) break; // destination full
+                    }
+                    req.progress += pushed;
+                    completed_read += static_cast<int>(pushed);
+                    finished = req.progress >= req.len;
+                    if (pushed) notify(req, pushed);
+                }
+            }
         }
-
-        size_t remaining_len = it->len - it->progress;
-        size_t can_complete = std::min(static_cast<size_t>(complete_bw_read_ - completed_read), remaining_len);
-        size_t pushed = 0;
-        while (pushed < can_complete && q->size() < it->max_queue_depth) {
-            uint32_t addr = it->addr + static_cast<uint32_t>(it->progress + pushed);
-            if (addr >= memory_.size()) break;
-            q->push_back(memory_[addr]);
-            pushed++;
+        if (finished) {
+            free_slots_.push_back(slot);
+            pending_count_--;
+        } else {
+            ready_[kept++] = slot;
         }
+    }
+    // Close the gap left by completed requests in the scanned prefix.
+    if (kept != i) ready_.erase(ready_.begin() + static_cast<std::ptrdiff_t>(kept),
+                                ready_.begin() + static_cast<std::ptrdiff_t>(i));
+}
 
-        it->progress += pushed;
-        completed_read += static_cast<int>(pushed);
-
-        if (it->progress >= it->len) {
-            it = pending_requests_.erase(it);
-            continue;
+Cycle Mem::cycles_until_event() const {
+    if (!ready_.empty()) return 1;
+    if (waiting_count_ == 0) return UINT64_MAX;
+    // Walk one wheel turn for the first bucket holding an entry due that
+    // cycle; entries further out are only possible after a checkpoint load
+    // with mixed latencies, so fall back to a full scan for those.
+    const uint64_t turn = wheel_mask_ + 1;
+    for (uint64_t dt = 1; dt <= turn; ++dt) {
+        const uint64_t t = current_cycle_ + dt;
+        for (uint32_t slot : wheel_[static_cast<size_t>(t & wheel_mask_)]) {
+            if (slots_[slot].ready_cycle <= t) return static_cast<Cycle>(dt);
         }
-
-        ++it;
     }
+    uint64_t earliest = UINT64_MAX;
+    for (const auto &bucket : wheel_) {
+        for (uint32_t slot : bucket) earliest = std::min(earliest, slots_[slot].ready_cycle);
+    }
+    return static_cast<Cycle>(earliest - current_cycle_);
+}
+
+void Mem::skip(Cycle n) {
+    if (n == 0) return;
+    // Ready cycles are absolute and callers only skip up to
+    // cycles_until_event() - 1, so no bucket falls due in between.
+    current_cycle_ += n;
+    issued_read_this_cycle_ = 0;
+    issued_write_this_cycle_ = 0;
 }
 
 void Mem::pv_write(uint64_t dataAddr, size_t size, uint64_t memAddr) {
     // Interpret dataAddr as pointer to DataType elements in host memory.
     const DataType* src = reinterpret_cast<const DataType*>(static_cast<uintptr_t>(dataAddr));
-    uint64_t offset = memAddr;
-    if (offset + size > memory_.size()) {
-        memory_.resize(static_cast<size_t>(offset + size));
-    }
-    for (size_t i = 0; i < size; ++i) {
-        memory_[static_cast<size_t>(offset + i)] = src[i];
-    }
+    memory_.write(memAddr, size, src);
 }
 
-void Mem::store_acc_direct(uint32_t addr, AccType val) {
-    if (addr >= acc_memory_.size()) {
-        // expand accumulator storage if needed
-        acc_memory_.resize(addr + 1);
-    }
-    acc_memory_[addr] += val;
+bool Mem::map_file(const std::string &path, Addr memAddr, size_t *elems) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    bool ok = fstat(fd, &st) == 0 && st.st_size % static_cast<off_t>(sizeof(DataType)) == 0;
+    const uint64_t n = ok ? static_cast<uint64_t>(st.st_size) / sizeof(DataType) : 0;
+    // The mapping keeps its own reference to the file.
+    ok = ok && memory_.map_file(fd, n, memAddr);
+    close(fd);
+    if (ok && elems) *elems = static_cast<size_t>(n);
+    return ok;
+}
+
+void Mem::store_acc_direct(Addr addr, AccType val) {
+    // pages are allocated on demand; the extent grows with the highest address
+    acc_memory_.at(addr) += val;
+}
+
+bool Mem::load_direct(Addr addr, size_t len, DataType *dst) const {
+    if (addr + len > memory_.size()) return false;
+    memory_.read(addr, len, dst);
+    return true;
 }
 
 bool Mem::pv_read(uint64_t memAddr, size_t size, uint64_t dataAddr) const {
@@ -163,6 +544,142 @@ bool Mem::pv_read(uint64_t memAddr, size_t size, uint64_t dataAddr) const {
     uint64_t addr = memAddr;
     if (addr + size > acc_memory_.size()) return false;
     AccType* dst = reinterpret_cast<AccType*>(static_cast<uintptr_t>(dataAddr));
-    for (size_t i = 0; i < size; ++i) dst[i] = acc_memory_[static_cast<size_t>(addr + i)];
+    acc_memory_.read(addr, size, dst);
+    return true;
+}
+
+namespace {
+// Fixed-layout image of a pending request used in checkpoints.
+struct RequestImage {
+    uint64_t addr;
+    int32_t stream;
+    uint8_t is_write;
+    DataType write_data;
+    int32_t remaining_cycles;
+    uint64_t len;
+    uint64_t progress;
+    uint32_t count;
+    uint64_t stride;
+    int32_t row_step;
+    int32_t col_step;
+    int32_t sink;
+    uint32_t tag;
+};
+
+// Sparse region image: extent, resident page count, then (index, page) pairs.
+template<typename T>
+void save_pages(util::SnapshotWriter &w, const util::PagedStore<T> &store) {
+    w.put<uint64_t>(store.size());
+    w.put<uint64_t>(store.resident_pages());
+    store.for_each_page([&](uint64_t p, const T *data) {
+        w.put(p);
+        w.put_bytes(data, util::PagedStore<T>::kPageElems * sizeof(T));
+    });
+}
+
+template<typename T>
+bool load_pages(util::SnapshotReader &r, util::PagedStore<T> &store) {
+    uint64_t size = 0, pages = 0;
+    if (!r.get(size) || !r.get(pages)) return false;
+    store.clear();
+    for (uint64_t i = 0; i < pages; ++i) {
+        uint64_t p = 0;
+        if (!r.get(p) || !r.get_bytes(store.page_for_write(p), util::PagedStore<T>::kPageElems * sizeof(T))) return false;
+    }
+    store.resize(size);
+    return true;
+}
+} // namespace
+
+void Mem::save(util::SnapshotWriter &w) const {
+    w.tag("MEM ");
+    w.put(latency_);
+    w.put(max_outstanding_);
+    w.put(issue_bw_read_);
+    w.put(issue_bw_write_);
+    w.put(complete_bw_read_);
+    w.put(complete_bw_write_);
+    w.put(current_cycle_);
+    w.put(issued_read_this_cycle_);
+    w.put(issued_write_this_cycle_);
+    save_pages(w, memory_);
+    save_pages(w, acc_memory_);
+    w.put(banked_);
+    w.put(bank_count_);
+    w.put(bank_interleave_);
+    w.put(bank_row_size_);
+    w.put(row_hit_latency_);
+    w.put(row_miss_latency_);
+    w.put_vec(banks_);
+    w.put(bank_stats_);
+    // Pending requests in issue order, with the remaining latency expressed
+    // the way a per-request countdown would see it.
+    std::vector<const Request*> live;
+    live.reserve(pending_count_);
+    for (uint32_t slot : ready_) live.push_back(&slots_[slot]);
+    for (const auto &bucket : wheel_) {
+        for (uint32_t slot : bucket) live.push_back(&slots_[slot]);
+    }
+    std::sort(live.begin(), live.end(), [](const Request *a, const Request *b) { return a->seq < b->seq; });
+    std::vector<RequestImage> reqs;
+    reqs.reserve(live.size());
+    for (const Request *rp : live) {
+        const Request &r = *rp;
+        RequestImage img{};
+        img.addr = r.addr;
+        img.stream = r.stream;
+        img.is_write = r.is_write ? 1 : 0;
+        img.write_data = r.write_data;
+        img.remaining_cycles = r.ready_cycle > current_cycle_
+                                   ? static_cast<int32_t>(r.ready_cycle - current_cycle_ - 1) : 0;
+        img.len = r.len;
+        img.progress = r.progress;
+        img.count = r.count;
+        img.stride = r.stride;
+        img.row_step = r.row_step;
+        img.col_step = r.col_step;
+        img.sink = r.sink;
+        img.tag = r.tag;
+        reqs.push_back(img);
+    }
+    w.put_vec(reqs);
+    for (const Request *rp : live) w.put_vec(rp->acc_data);
+}
+
+bool Mem::load(util::SnapshotReader &r) {
+    if (!r.expect_tag("MEM ")) return false;
+    bool ok = r.get(latency_) && r.get(max_outstanding_) &&
+              r.get(issue_bw_read_) && r.get(issue_bw_write_) &&
+              r.get(complete_bw_read_) && r.get(complete_bw_write_) &&
+              r.get(current_cycle_) && r.get(issued_read_this_cycle_) && r.get(issued_write_this_cycle_) &&
+              load_pages(r, memory_) && load_pages(r, acc_memory_);
+    std::vector<Bank> banks;
+    BankStats bank_stats{0, 0, 0};
+    ok = ok && r.get(banked_) && r.get(bank_count_) && r.get(bank_interleave_) && r.get(bank_row_size_) &&
+         r.get(row_hit_latency_) && r.get(row_miss_latency_) && r.get_vec(banks) && r.get(bank_stats);
+    std::vector<RequestImage> reqs;
+    if (!ok || !r.get_vec(reqs)) return false;
+    reset_queue();
+    banks_ = std::move(banks);
+    bank_stats_ = bank_stats;
+    for (const auto &img : reqs) {
+        Request req;
+        req.addr = img.addr;
+        if (img.stream >= static_cast<int32_t>(streams_.size())) return false;
+        req.stream = img.stream;
+        req.is_write = img.is_write != 0;
+        req.write_data = img.write_data;
+        req.ready_cycle = current_cycle_ + static_cast<uint64_t>(std::max(0, img.remaining_cycles)) + 1;
+        req.len = static_cast<size_t>(img.len);
+        req.progress = static_cast<size_t>(img.progress);
+        req.count = std::max<uint32_t>(1, img.count);
+        req.stride = img.stride;
+        req.row_step = img.row_step;
+        req.col_step = img.col_step;
+        req.sink = img.sink;
+        req.tag = img.tag;
+        if (!r.get_vec(req.acc_data)) return false;
+        enqueue(std::move(req));
+    }
     return true;
 }
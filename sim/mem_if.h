@@ -1,25 +1,30 @@
 // mem_if.h — 内存接口（中文注释）
 // 定义了仿真中的内存模型接口 `Mem`，支持异步读写请求、突发读取、
-// 完成队列（completion queue）以及按周期推进的行为。外部驱动通过
-// 提交请求并在完成队列中读取数据来与内存模型交互。
+// 完成流（stream）以及按周期推进的行为。使用方预先注册目标 FIFO 得到
+// stream id，读请求完成时数据直接写入该 FIFO 的环形存储。
 #ifndef MEMORY_INTERFACE_H
 #define MEMORY_INTERFACE_H
 
 #include <deque>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "types.h"
 #include "fifo.h"
+#include "util/paged_store.h"
 
 class Clock;
+class MemTraceWriter;
+namespace util { class SnapshotWriter; class SnapshotReader; }
 
 class Mem {
 private:
-    std::vector<DataType> memory_;
+    // Both regions are sparse: pages are allocated on first write.
+    util::PagedStore<DataType> memory_;
     // accumulator memory region (stores 32-bit accumulator results)
-    std::vector<AccType> acc_memory_;
+    util::PagedStore<AccType> acc_memory_;
     int latency_;
     int max_outstanding_;
     int issue_bw_read_;
@@ -30,18 +35,103 @@ private:
     int issued_read_this_cycle_;
     int issued_write_this_cycle_;
     struct Request {
-        uint32_t addr;
-        // shared pointer to a completion queue where completed data will be pushed
-        std::shared_ptr<std::deque<DataType>> completion_queue;
-        // maximum allowed elements in the completion queue before we consider it "full"
-        size_t max_queue_depth;
+        Addr addr;
+        // destination stream of a read (-1: data is discarded); a full FIFO
+        // holds the request back
+        int stream;
         bool is_write;
         DataType write_data;
-        int remaining_cycles;
-        size_t len;      // burst length (for reads)
+        uint64_t ready_cycle; // first cycle() (by current_cycle_) that may complete it
+        uint64_t seq;         // issue order; completion priority among ready requests
+        size_t len;      // total elements (for reads): count * repeat
         size_t progress; // how many elements already produced
+        // 2D shape of a read: rows of `count` elements whose starts are
+        // `stride` apart; element (r, c) goes to stream + r*row_step + c*col_step.
+        uint32_t count;
+        Addr stride;
+        int row_step;
+        int col_step;
+        // accumulator write burst: added (+=) into the accumulator region at
+        // addr.. on completion; empty for plain data writes
+        std::vector<AccType> acc_data;
+        // completion sink notified as read elements land (-1: none), with the
+        // issuer's tag
+        int sink;
+        uint32_t tag;
     };
-    std::vector<Request> pending_requests_;
+    // Pending requests live in a slot pool. Waiting ones sit in a timing wheel
+    // bucket indexed by ready_cycle (hashed: an entry may be whole turns ahead);
+    // due ones move to ready_ in issue order. cycle() only touches the bucket
+    // of the current cycle and the head of ready_.
+    std::vector<Request> slots_;
+    std::vector<uint32_t> free_slots_;
+    std::vector<std::vector<uint32_t>> wheel_;
+    uint64_t wheel_mask_;
+    std::deque<uint32_t> ready_;
+    size_t pending_count_;
+    size_t waiting_count_;
+    size_t ready_writes_;
+    uint64_t next_seq_;
+    // Registered completion streams (non-owning; nullptr = unregistered id).
+    std::vector<FIFO*> streams_;
+
+public:
+    // 分 bank 模型统计（memory.banked = true 时有效）
+    struct BankStats {
+        uint64_t row_hits;
+        uint64_t row_misses;
+        uint64_t conflict_cycles; // accesses waiting for a busy bank, summed
+    };
+
+private:
+    // Banked timing (memory.banked). Each bank serves its accesses in arrival
+    // order, so its queue is fully described by the cycle it frees up and the
+    // open row; a request's ready_cycle is resolved against them at issue and
+    // then rides the timing wheel like any other, so cycle() costs nothing
+    // extra and only the banks a request touches are visited.
+    struct Bank {
+        int64_t open_row;   // -1: no row open
+        uint64_t next_free; // first cycle the bank can start another access
+    };
+    bool banked_;
+    int bank_count_;
+    int bank_interleave_;   // consecutive elements mapped to one bank
+    int bank_row_size_;     // elements per row buffer within a bank
+    int row_hit_latency_;
+    int row_miss_latency_;
+    std::vector<Bank> banks_;
+    BankStats bank_stats_;
+
+public:
+    // 读合并统计（memory.coalesce = true 时有效）
+    struct CoalesceStats {
+        uint64_t merged_reads;   // reads absorbed into an earlier pending burst
+        uint64_t bursts;         // pending reads that absorbed at least one other
+        uint64_t peak_pending;   // most requests outstanding at once
+    };
+
+private:
+    // Read coalescing (memory.coalesce). The most recently accepted read
+    // stays open for coalesce_window_ cycles while it waits for its
+    // latency: a read that continues it (next address, same destination
+    // pattern, same sink and tag) is appended to it instead of taking a
+    // slot and an issue credit.
+    int coalesce_window_;        // 0: off
+    uint32_t coalesce_slot_;
+    uint64_t coalesce_seq_;      // seq of the open read; a reused slot does not match
+    uint64_t coalesce_opened_;   // cycle the open read was issued
+    bool coalesce_valid_;
+    bool coalesce_grown_;        // the open read has absorbed another
+    CoalesceStats coalesce_stats_;
+
+    FIFO *stream_fifo(int stream) const {
+        return stream >= 0 && stream < static_cast<int>(streams_.size()) ? streams_[static_cast<size_t>(stream)] : nullptr;
+    }
+    uint64_t bank_access(Addr addr, uint32_t len, uint64_t start);
+    uint64_t banked_ready_cycle(const Request &req);
+    uint32_t enqueue(Request &&req);
+    void make_ready(std::vector<uint32_t> &due);
+    void reset_queue();
 
 public:
     // New constructor: parameters are read from the configuration file. If
@@ -49,27 +139,100 @@ public:
     // (`model_cfg.toml`, `config/model.toml`). The `clock` parameter is
     // optional and currently unused by the memory model itself.
     Mem(p_clock_t clock = nullptr);
+    ~Mem();
 
     // Configuration is provided via per-key getters.
 
-    // 向 memory 发起读请求，完成后数据会被 push 到 completion_queue（遵守 max_queue_depth）
-    // completion_queue is non-owning; caller must ensure it lives until request completes
-    bool read_request(uint32_t addr, std::shared_ptr<std::deque<DataType>> completion_queue, size_t max_queue_depth = SIZE_MAX, size_t len = 1);
-    bool write_request(uint32_t addr, DataType data);
+    // 注册完成流：返回 stream id，读请求完成的数据直接 push 进 `fifo`（满则等待）。
+    // The FIFO is not owned and must outlive the registration.
+    int register_stream(FIFO *fifo);
+    void unregister_stream(int stream);
+
+    // 完成通知：读请求的数据每落入目标 FIFO 一批，就以 (tag, 元素数) 调用
+    // 请求所指的 sink，发起方（如 DmaEngine）据此得知传输何时完成。
+    // 与 stream 一样按注册顺序编号，检查点加载前须按相同顺序重新注册。
+    // The sink runs inside cycle() and must not issue requests itself.
+    using CompletionSink = std::function<void(uint32_t tag, size_t elems)>;
+    int register_sink(CompletionSink sink);
+    void unregister_sink(int sink);
+
+    // 2D 跨步读描述符：`repeat` 行、每行 `count` 个连续元素，行首相距
+    // `stride` 个元素。整块只占一个请求（发射带宽 / 未完成窗口各记 1），
+    // 完成带宽仍按元素计。元素 (r, c) 写入
+    // stream + r * stream_row_step + c * stream_col_step。
+    struct ReadDescriptor {
+        Addr base = 0;
+        uint32_t count = 0;
+        Addr stride = 0;
+        uint32_t repeat = 1;
+        int stream = -1;
+        int stream_row_step = 0;
+        int stream_col_step = 0;
+        int sink = -1;      // completion sink (register_sink), -1: none
+        uint32_t tag = 0;   // passed to the sink
+    };
+
+    // 向 memory 发起读请求（`len` 个连续元素），完成后数据按序写入 `stream`
+    bool read_request(Addr addr, int stream, size_t len = 1);
+    bool read_request(const ReadDescriptor &desc);
+    bool write_request(Addr addr, DataType data);
+    // 累加器回写 burst：`len` 个结果写入累加器区（与 store_acc_direct 一样按 += 合并），
+    // 占一个写发射槽，完成带宽按元素计。`sink`（可选）随写入落地按元素数收到通知。
+    bool acc_write_request(Addr addr, const AccType *vals, size_t len, int sink = -1, uint32_t tag = 0);
 
     void cycle();  // 每个周期调用
+    // Event-driven support: number of cycles until the next cycle() call that
+    // has work to do (1 = the very next cycle; UINT64_MAX when idle), and a
+    // bulk equivalent of `n` cycle() calls during which nothing completes.
+    Cycle cycles_until_event() const;
+    void skip(Cycle n);
     // PV write: 将宿主内存中的数据写入模拟内存。
     // dataAddr: 指向宿主内存中首元素的地址（按 DataType 计），
     // size: 元素数量（DataType 个数），
     // memAddr: 模拟内存中的目标地址（按元素索引计）。
     void pv_write(uint64_t dataAddr, size_t size, uint64_t memAddr);
-    bool has_pending() const { return !pending_requests_.empty(); }
+    // 将二进制文件（DataType 数组）写时复制映射到模拟内存 `memAddr` 处：
+    // 对齐的整页直接映射（零拷贝、进程间共享页缓存），边缘部分读入普通页。
+    // 成功时可选返回元素个数；文件无法打开或大小不是 DataType 整数倍时返回 false。
+    bool map_file(const std::string &path, Addr memAddr, size_t *elems = nullptr);
+    bool has_pending() const { return pending_count_ != 0; }
+    // No request in flight and no issue budget used this cycle: the timing of
+    // whatever happens next depends only on what is issued from here on.
+    bool idle() const {
+        return pending_count_ == 0 && issued_read_this_cycle_ == 0 && issued_write_this_cycle_ == 0;
+    }
+    // True when no further request can be accepted until one completes.
+    bool outstanding_full() const { return static_cast<int>(pending_count_) >= max_outstanding_; }
     // Expose configured latency for callers
     int get_latency() const { return latency_; }
+    int get_bandwidth() const { return complete_bw_read_; }
+    int get_max_outstanding() const { return max_outstanding_; }
+    bool banked() const { return banked_; }
+    // Memory-side cycle counter (advanced by cycle() and skip()).
+    Cycle now() const { return current_cycle_; }
+    // Grow the addressable extent of both regions to at least `size`
+    // elements; nothing is allocated.
+    void extend(Addr size);
+
+    // 访问轨迹记录（见 mem_trace.h）：此后每个被接受的请求都以
+    // (周期, 操作, 地址, 长度) 追加到 `path`；memory.trace_file 非空时构造即开始。
+    bool start_trace(const std::string &path);
+    void stop_trace();
+    const MemTraceWriter *trace() const { return trace_.get(); }
+    // Host memory held by allocated pages of both regions.
+    uint64_t resident_bytes() const { return memory_.resident_bytes() + acc_memory_.resident_bytes(); }
+    // Pages of the data region backed directly by a mapped file.
+    size_t mapped_pages() const { return memory_.mapped_pages(); }
+    const BankStats &get_bank_stats() const { return bank_stats_; }
+    bool coalescing() const { return coalesce_window_ > 0; }
+    const CoalesceStats &get_coalesce_stats() const { return coalesce_stats_; }
 
     // Store accumulator (32-bit) values directly into an accumulator memory
     // region. These are synchronous helpers used by the Cube to commit results.
-    void store_acc_direct(uint32_t addr, AccType val);
+    void store_acc_direct(Addr addr, AccType val);
+    // Synchronous bulk read of `len` elements starting at `addr`, bypassing
+    // latency and bandwidth (functional mode). False if out of range.
+    bool load_direct(Addr addr, size_t len, DataType *dst) const;
 
     // PV read: 从模拟累加器内存读取 `size` 个元素到宿主内存。
     // memAddr: 模拟内存地址（按元素索引）；
@@ -77,7 +240,21 @@ public:
     // dataAddr: 指向宿主内存目标缓冲区的地址（按 AccType 计）。
     bool pv_read(uint64_t memAddr, size_t size, uint64_t dataAddr) const;
 
+    // Checkpoint support. Pending reads keep their stream id; the owner must
+    // register its streams in the same order before loading.
+    void save(util::SnapshotWriter &w) const;
+    bool load(util::SnapshotReader &r);
+
 private:
+    std::unique_ptr<MemTraceWriter> trace_;
+    // Registered completion sinks (empty function = unregistered id).
+    std::vector<CompletionSink> sinks_;
+    void notify(const Request &req, size_t elems) const {
+        if (req.sink >= 0 && req.sink < static_cast<int>(sinks_.size()) && sinks_[static_cast<size_t>(req.sink)])
+            sinks_[static_cast<size_t>(req.sink)](req.tag, elems);
+    }
+    bool coalesce_read(const ReadDescriptor &desc);
+
     // Load configuration values (reads the runtime default config path).
     void config();
 };
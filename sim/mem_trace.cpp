@@ -0,0 +1,229 @@
+#include "mem_trace.h"
+#include "mem_if.h"
+#include "fifo.h"
+#include "util/snapshot.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+// mem_trace.cpp — 轨迹编码与回放驱动。
+// 文件格式：4 字节 "XTRC" + uint32 版本号，随后逐条记录：
+//   varint((周期差 << 2) | op)，zigzag varint(地址差)，
+//   READ / ACC_WRITE: varint(len)；READ_2D: varint(count), varint(stride), varint(repeat)；WRITE: 无。
+
+static constexpr uint32_t kTraceVersion = 1;
+static constexpr size_t kFlushBytes = 64 * 1024;
+
+static uint64_t zigzag(int64_t v) { return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63); }
+static int64_t unzigzag(uint64_t v) { return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1); }
+
+MemTraceWriter::MemTraceWriter(const std::string &path)
+    : ofs_(path, std::ios::binary | std::ios::trunc) {
+    ofs_.write("XTRC", 4);
+    ofs_.write(reinterpret_cast<const char*>(&kTraceVersion), sizeof(kTraceVersion));
+    bytes_ = 4 + sizeof(kTraceVersion);
+    buf_.reserve(kFlushBytes + 64);
+}
+
+MemTraceWriter::~MemTraceWriter() {
+    flush();
+}
+
+void MemTraceWriter::put_varint(uint64_t v) {
+    while (v >= 0x80) {
+        buf_.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    buf_.push_back(static_cast<uint8_t>(v));
+}
+
+void MemTraceWriter::record(const MemTraceRecord &r) {
+    const size_t before = buf_.size();
+    put_varint(((r.cycle - last_cycle_) << 2) | static_cast<uint64_t>(r.op));
+    put_varint(zigzag(static_cast<int64_t>(r.addr - last_addr_)));
+    switch (r.op) {
+        case MemTraceOp::READ:
+        case MemTraceOp::ACC_WRITE:
+            put_varint(r.len);
+            break;
+        case MemTraceOp::READ_2D:
+            put_varint(r.count);
+            put_varint(r.stride);
+            put_varint(r.repeat);
+            break;
+        case MemTraceOp::WRITE:
+            break;
+    }
+    last_cycle_ = r.cycle;
+    last_addr_ = r.addr;
+    records_++;
+    bytes_ += buf_.size() - before;
+    if (buf_.size() >= kFlushBytes) flush();
+}
+
+void MemTraceWriter::flush() {
+    if (buf_.empty()) return;
+    ofs_.write(reinterpret_cast<const char*>(buf_.data()), static_cast<std::streamsize>(buf_.size()));
+    ofs_.flush();
+    buf_.clear();
+}
+
+MemTraceReader::MemTraceReader(const std::string &path)
+    : in_(new util::SnapshotReader(path)) {
+    uint32_t version = 0;
+    ok_ = in_->good() && in_->expect_tag("XTRC") && in_->get(version) && version == kTraceVersion;
+}
+
+MemTraceReader::~MemTraceReader() = default;
+
+bool MemTraceReader::get_varint(uint64_t &v) {
+    v = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+        uint8_t b = 0;
+        if (!in_->get(b)) return false;
+        v |= static_cast<uint64_t>(b & 0x7f) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+bool MemTraceReader::next(MemTraceRecord &r) {
+    uint64_t head = 0, daddr = 0;
+    if (!ok_ || !get_varint(head) || !get_varint(daddr)) return false;
+    r = MemTraceRecord{};
+    r.cycle = last_cycle_ + (head >> 2);
+    r.op = static_cast<MemTraceOp>(head & 3);
+    r.addr = last_addr_ + static_cast<Addr>(unzigzag(daddr));
+    uint64_t count = 0, stride = 0, repeat = 0;
+    switch (r.op) {
+        case MemTraceOp::READ:
+        case MemTraceOp::ACC_WRITE:
+            if (!get_varint(r.len)) return false;
+            break;
+        case MemTraceOp::READ_2D:
+            if (!get_varint(count) || !get_varint(stride) || !get_varint(repeat)) return false;
+            r.count = static_cast<uint32_t>(count);
+            r.stride = static_cast<Addr>(stride);
+            r.repeat = static_cast<uint32_t>(repeat);
+            r.len = count * repeat;
+            break;
+        case MemTraceOp::WRITE:
+            r.len = 1;
+            break;
+    }
+    last_cycle_ = r.cycle;
+    last_addr_ = r.addr;
+    return true;
+}
+
+// One past the last element a record touches.
+static Addr record_end(const MemTraceRecord &r) {
+    if (r.op == MemTraceOp::READ_2D) {
+        return r.repeat == 0 ? r.addr : r.addr + static_cast<Addr>(r.repeat - 1) * r.stride + r.count;
+    }
+    return r.addr + r.len;
+}
+
+bool replay_mem_trace(const std::string &path, Mem &mem, MemReplayStats &stats) {
+    stats = MemReplayStats{};
+    Addr extent = 0;
+    {
+        MemTraceReader scan(path);
+        if (!scan.good()) return false;
+        MemTraceRecord r;
+        while (scan.next(r)) extent = std::max(extent, record_end(r));
+    }
+    mem.extend(extent);
+
+    MemTraceReader rd(path);
+    // Every read lands in one FIFO that is emptied after each cycle, so
+    // completions are still paced element by element by Mem's bandwidth.
+    FIFO drain(std::max(4096, mem.get_bandwidth()));
+    const int stream = mem.register_stream(&drain);
+    struct PendingRead { Cycle issued; uint64_t remaining; };
+    std::unordered_map<uint32_t, PendingRead> reads;
+    double latency_sum = 0.0;
+    uint64_t reads_done = 0;
+    const int sink = mem.register_sink([&](uint32_t tag, size_t elems) {
+        auto it = reads.find(tag);
+        if (it == reads.end()) return;
+        it->second.remaining -= std::min<uint64_t>(elems, it->second.remaining);
+        if (it->second.remaining != 0) return;
+        latency_sum += static_cast<double>(mem.now() - it->second.issued);
+        reads_done++;
+        reads.erase(it);
+    });
+    std::vector<AccType> zeros;
+    uint32_t next_tag = 0;
+
+    auto issue = [&](const MemTraceRecord &r) {
+        switch (r.op) {
+            case MemTraceOp::READ:
+            case MemTraceOp::READ_2D: {
+                Mem::ReadDescriptor d;
+                d.base = r.addr;
+                d.count = r.op == MemTraceOp::READ ? static_cast<uint32_t>(r.len) : r.count;
+                d.stride = r.op == MemTraceOp::READ ? static_cast<Addr>(r.len) : r.stride;
+                d.repeat = r.op == MemTraceOp::READ ? 1 : r.repeat;
+                d.stream = stream;
+                d.sink = sink;
+                d.tag = next_tag;
+                if (!mem.read_request(d)) return false;
+                if (r.len) reads.emplace(next_tag, PendingRead{mem.now(), r.len});
+                next_tag++;
+                stats.reads++;
+                return true;
+            }
+            case MemTraceOp::WRITE:
+                if (!mem.write_request(r.addr, DataType{})) return false;
+                stats.writes++;
+                return true;
+            case MemTraceOp::ACC_WRITE:
+                if (zeros.size() < r.len) zeros.resize(static_cast<size_t>(r.len));
+                if (!mem.acc_write_request(r.addr, zeros.data(), static_cast<size_t>(r.len))) return false;
+                stats.writes++;
+                return true;
+        }
+        return false;
+    };
+
+    MemTraceRecord rec;
+    bool have = rd.next(rec);
+    const Cycle start = mem.now();
+    const Cycle first = have ? rec.cycle : 0;
+    Cycle slip = 0;
+    auto due = [&](const MemTraceRecord &r) { return start + (r.cycle - first) + slip; };
+    while (have || mem.has_pending()) {
+        bool refused = false;
+        while (have && due(rec) <= mem.now()) {
+            if (!issue(rec)) {
+                refused = true;
+                break;
+            }
+            stats.records++;
+            stats.elements += rec.len;
+            have = rd.next(rec);
+        }
+        // Next cycle worth simulating: a completion, the next due record, or
+        // (after a refusal) the cycle the issue budget or window frees up.
+        Cycle step = mem.cycles_until_event();
+        if (have && !(refused && mem.outstanding_full())) {
+            step = std::min<Cycle>(step, refused ? 1 : due(rec) - mem.now());
+        }
+        if (step == UINT64_MAX) break;
+        if (step > 1) mem.skip(step - 1);
+        mem.cycle();
+        drain.read_ptr = drain.write_ptr;
+        drain.count = 0;
+        if (refused) {
+            stats.rejected_cycles += step;
+            slip = mem.now() - (start + (rec.cycle - first));
+        }
+    }
+    stats.cycles = mem.now() - start;
+    stats.slip_cycles = slip;
+    stats.mean_read_latency = reads_done ? latency_sum / static_cast<double>(reads_done) : 0.0;
+    mem.unregister_sink(sink);
+    mem.unregister_stream(stream);
+    return true;
+}
@@ -0,0 +1,102 @@
+// mem_trace.h — 内存访问轨迹的记录与回放（中文注释）
+// Mem 接受的每个请求记录为 (周期, 操作, 地址, 长度[, 2D 形状])，以增量 +
+// 变长整数编码写入紧凑二进制文件：周期与地址都记为相对上一条记录的差值，
+// 常见记录只占 3~5 字节。回放驱动把轨迹按原发射周期注入任意配置的 Mem，
+// 不需要 PE 阵列，空闲周期直接跳过，可快速扫描 memory_latency / bandwidth /
+// max_outstanding 等参数。回放是开环的：请求之间的依赖未知，新配置拒绝某个
+// 请求时，它与其后的请求整体顺延（slip），但不会因为内存更快而提前。
+#ifndef MEM_TRACE_H
+#define MEM_TRACE_H
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "types.h"
+
+class Mem;
+namespace util { class SnapshotReader; }
+
+enum class MemTraceOp : uint8_t {
+    READ = 0,       // `len` consecutive elements
+    READ_2D = 1,    // `repeat` rows of `count` elements, `stride` apart
+    WRITE = 2,      // one data element
+    ACC_WRITE = 3   // accumulator burst of `len` elements
+};
+
+struct MemTraceRecord {
+    Cycle cycle;    // Mem cycle at which the request was accepted
+    MemTraceOp op;
+    Addr addr;
+    uint64_t len;   // elements (count * repeat for READ_2D)
+    uint32_t count;
+    Addr stride;
+    uint32_t repeat;
+};
+
+class MemTraceWriter {
+public:
+    explicit MemTraceWriter(const std::string &path);
+    ~MemTraceWriter();
+    MemTraceWriter(const MemTraceWriter&) = delete;
+    MemTraceWriter& operator=(const MemTraceWriter&) = delete;
+
+    bool good() const { return static_cast<bool>(ofs_); }
+    void record(const MemTraceRecord &r);
+    void flush();
+    uint64_t records() const { return records_; }
+    uint64_t bytes() const { return bytes_; }
+
+private:
+    void put_varint(uint64_t v);
+
+    std::ofstream ofs_;
+    std::vector<uint8_t> buf_;
+    Cycle last_cycle_ = 0;
+    Addr last_addr_ = 0;
+    uint64_t records_ = 0;
+    uint64_t bytes_ = 0;
+};
+
+class MemTraceReader {
+public:
+    explicit MemTraceReader(const std::string &path);
+    ~MemTraceReader();
+    MemTraceReader(const MemTraceReader&) = delete;
+    MemTraceReader& operator=(const MemTraceReader&) = delete;
+
+    // False if the file is missing or has no valid header.
+    bool good() const { return ok_; }
+    // Next record; false at the end of the trace or on a truncated record.
+    bool next(MemTraceRecord &r);
+
+private:
+    bool get_varint(uint64_t &v);
+
+    std::unique_ptr<util::SnapshotReader> in_;
+    bool ok_ = false;
+    Cycle last_cycle_ = 0;
+    Addr last_addr_ = 0;
+};
+
+// 回放统计
+struct MemReplayStats {
+    uint64_t records;
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t elements;
+    uint64_t cycles;            // first issue to last completion
+    uint64_t slip_cycles;       // how far the last request issued behind its recorded cycle
+    uint64_t rejected_cycles;   // cycles in which a due request was refused
+    double mean_read_latency;   // issue to last element landed, per read
+};
+
+// Feed the trace at `path` into `mem` at the recorded issue cycles (shifted
+// by the accumulated slip) until every request has completed. Read data is
+// discarded; written locations are overwritten with zeros (accumulator
+// bursts add zero). False if the trace cannot be read.
+bool replay_mem_trace(const std::string &path, Mem &mem, MemReplayStats &stats);
+
+#endif // MEM_TRACE_H
@@ -7,7 +7,7 @@
 #include <iostream>
 PE::PE(int x, int y) 
     : id_x(x), id_y(y), weight(0), activation(0), 
-      accumulator(0), weight_valid(false), active(false) {
+      accumulator(0), weight_valid(false), active(false), last_mac(false) {
     reset();
 }
 
@@ -18,6 +18,7 @@ void PE::reset() {
     accumulator = 0;
     weight_valid = false;
     active = false;
+    last_mac = false;
     pipeline_reg.activation = 0;
     pipeline_reg.partial_sum = 0;
     pipeline_reg.staged_weight = 0;
@@ -65,7 +66,8 @@ void PE::compute_cycle(DataType act_in, AccType psum_in,
     AccType mac_result = 0;
     DataType used_weight = pipeline_reg.staged_weight_valid ? pipeline_reg.staged_weight : weight;
     bool used_weight_valid = pipeline_reg.staged_weight_valid ? true : weight_valid;
-    if (used_weight_valid && act_in != 0) {
+    last_mac = used_weight_valid && act_in != 0;
+    if (last_mac) {
         mac_result = static_cast<AccType>(act_in) * static_cast<AccType>(used_weight);
     }
     AccType new_psum = psum_in + mac_result;
@@ -14,6 +14,7 @@ private:
     AccType accumulator;      // 累加器
     bool weight_valid;        // 权重是否有效
     bool active;              // PE是否激活
+    bool last_mac;            // 上一次 tick 是否做了乘加（有效权重且激活非零）
 
     // 流水线寄存器
     struct {
@@ -60,6 +61,9 @@ public:
     bool is_active() const { return active; }
     
     bool has_weight() const { return weight_valid; }
+    // Whether the last tick multiplied: a valid weight (the one arriving this
+    // cycle, else its own) and a nonzero activation.
+    bool did_mac() const { return last_mac; }
     
     // 打印状态
     void print_state() const;
@@ -0,0 +1,236 @@
+#// 文件：pe_grid.cpp
+#// 说明：PEGrid 实现。每个阶段都是对连续行缓冲区的无分支循环，
+#// 便于编译器自动向量化；启用 AVX2 编译时 tick 使用显式 SIMD 内核。
+#include "pe_grid.h"
+#include "util/snapshot.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+PEGrid::PEGrid(int rows, int cols)
+    : rows_(rows), cols_(cols), active_rows_(0), active_cols_(0), armed_(false),
+      psum_down_(false), preload_(false),
+      min_parallel_pes_(0), bands_(1),
+      edge_left_(nullptr), edge_top_(nullptr), edge_top_valid_(nullptr) {
+    std::size_t n = static_cast<std::size_t>(rows) * static_cast<std::size_t>(cols);
+    weight_.assign(n, 0);
+    act_.assign(n, 0);
+    acc_.assign(n, 0);
+    weight_valid_.assign(n, 0);
+    in_act_.assign(n, 0);
+    in_psum_.assign(n, 0);
+    in_weight_.assign(n, 0);
+    in_weight_valid_.assign(n, 0);
+    next_psum_.assign(n, 0);
+}
+
+void PEGrid::reset() {
+    std::fill(weight_.begin(), weight_.end(), 0);
+    std::fill(act_.begin(), act_.end(), 0);
+    std::fill(acc_.begin(), acc_.end(), 0);
+    std::fill(weight_valid_.begin(), weight_valid_.end(), 0);
+    std::fill(in_act_.begin(), in_act_.end(), 0);
+    std::fill(in_psum_.begin(), in_psum_.end(), 0);
+    std::fill(in_weight_.begin(), in_weight_.end(), 0);
+    std::fill(in_weight_valid_.begin(), in_weight_valid_.end(), 0);
+    std::fill(next_psum_.begin(), next_psum_.end(), 0);
+    active_rows_ = active_cols_ = 0;
+    armed_ = false;
+}
+
+void PEGrid::begin_tile(int m, int n) {
+    active_rows_ = std::min(m, rows_);
+    active_cols_ = std::min(n, cols_);
+    for (int i = 0; i < active_rows_; ++i) {
+        std::fill_n(&acc_[idx(i, 0)], active_cols_, 0);
+        std::fill_n(&act_[idx(i, 0)], active_cols_, 0);
+    }
+    armed_ = false;
+}
+
+void PEGrid::set_dataflow(Dataflow dataflow) {
+    psum_down_ = dataflow != Dataflow::OUTPUT_STATIONARY;
+    preload_ = false;
+}
+
+void PEGrid::load_weight(int i, int j, DataType w) {
+    weight_[idx(i, j)] = w;
+    weight_valid_[idx(i, j)] = 1;
+}
+
+void PEGrid::set_workers(std::shared_ptr<util::WorkerPool> pool, int min_pes) {
+    pool_ = std::move(pool);
+    min_parallel_pes_ = min_pes;
+    // jobs are built once so the per-cycle dispatch does not allocate
+    prepare_job_ = [this](int b) { int r0, r1; band_rows(b, r0, r1); band_macs_[b] = prepare_rows(r0, r1); };
+    tick_job_ = [this](int b) { int r0, r1; band_rows(b, r0, r1); tick_rows(r0, r1); };
+    commit_job_ = [this](int b) { int r0, r1; band_rows(b, r0, r1); commit_rows(r0, r1); };
+}
+
+int PEGrid::band_count() const {
+    if (!pool_ || pool_->size() <= 1) return 1;
+    if (active_rows_ * active_cols_ < min_parallel_pes_) return 1;
+    return std::min(pool_->size(), active_rows_);
+}
+
+void PEGrid::band_rows(int band, int &r0, int &r1) const {
+    r0 = static_cast<int>(static_cast<int64_t>(active_rows_) * band / bands_);
+    r1 = static_cast<int>(static_cast<int64_t>(active_rows_) * (band + 1) / bands_);
+}
+
+uint64_t PEGrid::prepare(const DataType *left_in, const DataType *top_in, const char *top_valid) {
+    edge_left_ = left_in;
+    edge_top_ = top_in;
+    edge_top_valid_ = top_valid;
+    armed_ = true;
+    bands_ = band_count();
+    if (bands_ <= 1) return prepare_rows(0, active_rows_);
+    band_macs_.assign(static_cast<size_t>(bands_), 0);
+    pool_->run(bands_, prepare_job_);
+    uint64_t macs = 0;
+    for (uint64_t m : band_macs_) macs += m;
+    return macs;
+}
+
+uint64_t PEGrid::prepare_rows(int r0, int r1) {
+    const DataType *left_in = edge_left_;
+    const DataType *top_in = edge_top_;
+    const char *top_valid = edge_top_valid_;
+    const int n = active_cols_;
+    uint64_t macs = 0;
+    for (int i = r0; i < r1; ++i) {
+        const std::size_t row = idx(i, 0);
+        // activations move one PE to the right; the left edge takes the new input
+        DataType *ia = &in_act_[row];
+        ia[0] = left_in[i];
+        if (n > 1) std::memcpy(ia + 1, &act_[row], static_cast<std::size_t>(n - 1) * sizeof(DataType));
+        if (!psum_down_) {
+            // partial sums stay in place (accumulate into the PE's own register)
+            std::memcpy(&in_psum_[row], &acc_[row], static_cast<std::size_t>(n) * sizeof(AccType));
+        } else if (i > 0) {
+            // partial sums move one PE down; row 0 starts from zero
+            std::memcpy(&in_psum_[row], &acc_[idx(i - 1, 0)], static_cast<std::size_t>(n) * sizeof(AccType));
+        } else {
+            std::fill_n(&in_psum_[row], n, 0);
+        }
+        // weights move one PE down; row 0 takes the top edge
+        if (psum_down_ && !preload_) {
+            // stationary: every PE keeps its weight
+            std::fill_n(&in_weight_valid_[row], n, 0);
+        } else if (i > 0) {
+            const std::size_t up = idx(i - 1, 0);
+            std::memcpy(&in_weight_[row], &weight_[up], static_cast<std::size_t>(n) * sizeof(DataType));
+            std::memcpy(&in_weight_valid_[row], &weight_valid_[up], static_cast<std::size_t>(n));
+        } else {
+            for (int j = 0; j < n; ++j) {
+                in_weight_[row + j] = top_in[j];
+                in_weight_valid_[row + j] = top_valid[j] ? 1 : 0;
+            }
+        }
+        // a MAC happens where the PE multiplies by a valid weight: the staged
+        // one if a weight arrives this cycle, else its own (as in tick_rows)
+        const uint8_t *wv = &weight_valid_[row];
+        const uint8_t *sv = &in_weight_valid_[row];
+        for (int j = 0; j < n; ++j) macs += ((wv[j] | sv[j]) & (ia[j] != 0));
+    }
+    return macs;
+}
+
+// Per PE: next_psum = psum_in + act_in * (staged weight if present, else own
+// weight). A PE without a valid weight always holds weight 0, so the product
+// needs no validity branch.
+void PEGrid::tick() {
+    if (!armed_) return;
+    if (bands_ <= 1) tick_rows(0, active_rows_);
+    else pool_->run(bands_, tick_job_);
+}
+
+void PEGrid::tick_rows(int r0, int r1) {
+    const int n = active_cols_;
+    for (int i = r0; i < r1; ++i) {
+        const std::size_t row = idx(i, 0);
+        const DataType *a = &in_act_[row];
+        const DataType *sw = &in_weight_[row];
+        const uint8_t *sv = &in_weight_valid_[row];
+        const DataType *w = &weight_[row];
+        const AccType *p = &in_psum_[row];
+        AccType *out = &next_psum_[row];
+        int j = 0;
+#if defined(__AVX2__)
+        for (; j + 8 <= n; j += 8) {
+            __m128i present = _mm_cmpgt_epi16(
+                _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(sv + j))),
+                _mm_setzero_si128());
+            __m128i used_w = _mm_blendv_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(w + j)),
+                                             _mm_loadu_si128(reinterpret_cast<const __m128i*>(sw + j)),
+                                             present);
+            __m256i prod = _mm256_mullo_epi32(
+                _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + j))),
+                _mm256_cvtepi16_epi32(used_w));
+            __m256i psum = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + j));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + j), _mm256_add_epi32(psum, prod));
+        }
+#endif
+        for (; j < n; ++j) {
+            DataType used_w = sv[j] ? sw[j] : w[j];
+            out[j] = p[j] + static_cast<AccType>(a[j]) * static_cast<AccType>(used_w);
+        }
+    }
+}
+
+void PEGrid::commit() {
+    if (!armed_) return;
+    if (bands_ <= 1) commit_rows(0, active_rows_);
+    else pool_->run(bands_, commit_job_);
+    armed_ = false;
+}
+
+void PEGrid::commit_rows(int r0, int r1) {
+    const int n = active_cols_;
+    for (int i = r0; i < r1; ++i) {
+        const std::size_t row = idx(i, 0);
+        std::memcpy(&act_[row], &in_act_[row], static_cast<std::size_t>(n) * sizeof(DataType));
+        std::memcpy(&acc_[row], &next_psum_[row], static_cast<std::size_t>(n) * sizeof(AccType));
+        DataType *w = &weight_[row];
+        uint8_t *wv = &weight_valid_[row];
+        const DataType *sw = &in_weight_[row];
+        uint8_t *sv = &in_weight_valid_[row];
+        for (int j = 0; j < n; ++j) {
+            w[j] = sv[j] ? sw[j] : w[j];
+            wv[j] |= sv[j];
+            sv[j] = 0;
+        }
+    }
+}
+
+void PEGrid::save(util::SnapshotWriter &w) const {
+    w.tag("GRID");
+    w.put(rows_);
+    w.put(cols_);
+    w.put(active_rows_);
+    w.put(active_cols_);
+    w.put(armed_);
+    w.put_vec(weight_);
+    w.put_vec(act_);
+    w.put_vec(acc_);
+    w.put_vec(weight_valid_);
+    w.put_vec(in_act_);
+    w.put_vec(in_psum_);
+    w.put_vec(in_weight_);
+    w.put_vec(in_weight_valid_);
+    w.put_vec(next_psum_);
+}
+
+bool PEGrid::load(util::SnapshotReader &r) {
+    int rows = 0, cols = 0;
+    if (!r.expect_tag("GRID") || !r.get(rows) || !r.get(cols)) return false;
+    if (rows != rows_ || cols != cols_) return false;
+    return r.get(active_rows_) && r.get(active_cols_) && r.get(armed_) &&
+           r.get_vec(weight_) && r.get_vec(act_) && r.get_vec(acc_) && r.get_vec(weight_valid_) &&
+           r.get_vec(in_act_) && r.get_vec(in_psum_) && r.get_vec(in_weight_) &&
+           r.get_vec(in_weight_valid_) && r.get_vec(next_psum_);
+}
@@ -0,0 +1,110 @@
+#// 文件：pe_grid.h
+#// 说明：整阵列 PE 引擎（结构体数组 SoA 布局）。
+#// 以扁平缓冲区保存所有 PE 的权重、激活、累加器与流水线寄存器，
+#// 一次调用即可对整个活动窗口完成 prepare_inputs / tick / commit，
+#// 语义与逐个 `PE` 的两阶段提交逐位一致。
+#ifndef PE_GRID_H
+#define PE_GRID_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "types.h"
+#include "util/worker_pool.h"
+
+namespace util { class SnapshotWriter; class SnapshotReader; }
+
+class PEGrid {
+public:
+    PEGrid(int rows = 0, int cols = 0);
+
+    int rows() const { return rows_; }
+    int cols() const { return cols_; }
+
+    // 复位所有 PE（等价于对每个 PE 调用 PE::reset）
+    void reset();
+
+    // Start a tile on the top-left `m x n` window: clear accumulators and
+    // activations there. Only the window is prepared/ticked/committed until
+    // the next call.
+    void begin_tile(int m, int n);
+
+    // Operand routing. Output-stationary (default): activations move right,
+    // weights move down every cycle and partial sums accumulate in place.
+    // Weight/input-stationary: weights only move down while `preload` is
+    // set and are held otherwise; activations move right and partial sums
+    // move down, so a finished sum leaves through the bottom row.
+    void set_dataflow(Dataflow dataflow);
+    void set_preload(bool preload) { preload_ = preload; }
+
+    // Stage next-cycle inputs for the whole window from the array edges:
+    // row i receives `left_in[i]`, column j of row 0 receives `top_in[j]` when
+    // `top_valid[j]` is set; interior PEs read their neighbours' committed
+    // registers. Returns the number of MACs issued this cycle (PEs holding a
+    // weight that see a non-zero activation).
+    uint64_t prepare(const DataType *left_in, const DataType *top_in, const char *top_valid);
+
+    // Two-phase update driven by the clock. Both are no-ops on cycles for
+    // which `prepare` was not called, so idle cycles leave the array frozen.
+    void tick();
+    void commit();
+
+    // Split prepare/tick/commit into row bands on `pool` once the active
+    // window holds at least `min_pes` PEs. Bands write disjoint rows, so the
+    // result is identical to the serial update.
+    void set_workers(std::shared_ptr<util::WorkerPool> pool, int min_pes);
+
+    // 广播权重（控制器的 LOADING_WEIGHTS 路径）
+    void load_weight(int i, int j, DataType w);
+
+    // Checkpoint support: every register plus the active window.
+    void save(util::SnapshotWriter &w) const;
+    bool load(util::SnapshotReader &r);
+
+    AccType accumulator(int i, int j) const { return acc_[idx(i, j)]; }
+    DataType activation(int i, int j) const { return act_[idx(i, j)]; }
+    DataType weight(int i, int j) const { return weight_[idx(i, j)]; }
+    bool has_weight(int i, int j) const { return weight_valid_[idx(i, j)] != 0; }
+
+private:
+    int rows_, cols_;
+    int active_rows_, active_cols_;
+    bool armed_;   // inputs staged for the current cycle
+    bool psum_down_;   // stationary dataflows: partial sums flow down
+    bool preload_;     // stationary dataflows: weights shift down this cycle
+
+    // 可见寄存器
+    std::vector<DataType> weight_;
+    std::vector<DataType> act_;
+    std::vector<AccType> acc_;
+    std::vector<uint8_t> weight_valid_;
+
+    // 流水线寄存器（prepare 写入，tick 计算，commit 写回）
+    std::vector<DataType> in_act_;
+    std::vector<AccType> in_psum_;
+    std::vector<DataType> in_weight_;
+    std::vector<uint8_t> in_weight_valid_;
+    std::vector<AccType> next_psum_;
+
+    // 并行行带（row band）执行
+    std::shared_ptr<util::WorkerPool> pool_;
+    int min_parallel_pes_;
+    int bands_;
+    std::vector<uint64_t> band_macs_;
+    const DataType *edge_left_;
+    const DataType *edge_top_;
+    const char *edge_top_valid_;
+    std::function<void(int)> prepare_job_, tick_job_, commit_job_;
+
+    std::size_t idx(int i, int j) const { return static_cast<std::size_t>(i) * cols_ + j; }
+    // number of bands for the current window (1 = run serially)
+    int band_count() const;
+    void band_rows(int band, int &r0, int &r1) const;
+    uint64_t prepare_rows(int r0, int r1);
+    void tick_rows(int r0, int r1);
+    void commit_rows(int r0, int r1);
+};
+
+#endif // PE_GRID_H
@@ -0,0 +1,134 @@
+#include "perf_model.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <utility>
+
+// perf_model.cpp — 解析式性能模型实现（中文注释）
+// 预取阶段把 Mem 看作按序服务的队列：A 以每行一个 k_tile 长度的 burst 发出，
+// B 子块作为一个 2D 描述符发出（或逐元素发出）；请求经过 latency + 1 个周期后可完成，完成带宽按元素计。
+// 发射受每周期带宽与未完成窗口双重限制，窗口满时发射速度退化为完成速度。
+
+TileBlocks tile_blocks(const PerfModelParams &p) {
+    auto pick = [](int want, int def, int bound) {
+        const int v = want > 0 ? want : def;
+        return bound > 0 ? std::min(v, bound) : v;
+    };
+    const int rows = p.array_rows, cols = p.array_cols;
+    switch (p.dataflow) {
+        case Dataflow::WEIGHT_STATIONARY:
+            return TileBlocks{pick(p.tile_m, rows, 0), pick(p.tile_n, cols, cols), pick(p.tile_k, rows, rows)};
+        case Dataflow::INPUT_STATIONARY:
+            return TileBlocks{pick(p.tile_m, cols, cols), pick(p.tile_n, cols, 0), pick(p.tile_k, rows, rows)};
+        case Dataflow::OUTPUT_STATIONARY: break;
+    }
+    TileBlocks b{pick(p.tile_m, rows, rows), pick(p.tile_n, cols, cols), pick(p.tile_k, cols, 0)};
+    if (p.k_accumulate) b.k = std::max(b.k, std::max(b.m, b.n));
+    return b;
+}
+
+uint64_t tile_compute_cycles(Dataflow dataflow, int m_tile, int n_tile, int k_tile, int mem_latency) {
+    const uint64_t preload = dataflow == Dataflow::OUTPUT_STATIONARY ? 0 : static_cast<uint64_t>(k_tile);
+    return preload + static_cast<uint64_t>(k_tile + m_tile + n_tile) + static_cast<uint64_t>(std::max(0, mem_latency));
+}
+
+PerfEstimate estimate_tile(const PerfModelParams &p, int m_tile, int n_tile, int k_tile) {
+    PerfEstimate e;
+    const double lat = std::max(0, p.mem_latency);
+    const double bw = std::max(1, p.bandwidth);
+    const double window = std::max(1, p.max_outstanding);
+
+    const double reqs_a = m_tile;
+    const double elems_b = static_cast<double>(k_tile) * n_tile;
+    const double reqs_b = p.b_descriptor ? 1.0 : elems_b;
+    const double reqs = reqs_a + reqs_b;
+    const double elems_a = static_cast<double>(m_tile) * k_tile;
+
+    // Single-element B reads are bounded by issue bandwidth and, once the
+    // window is full, by Little's law over the latency + 1 residence time.
+    // A descriptor streams its elements at the completion bandwidth.
+    const bool window_bound = reqs > window;
+    const double rate_b = window_bound && !p.b_descriptor ? std::min(bw, window / (lat + 1.0)) : bw;
+    const double elems_per_b = elems_b / reqs_b;
+
+    // Ticks until the first `x` requests have fully completed.
+    auto completed_by = [&](double x) {
+        if (x <= 0) return 0.0;
+        if (x <= reqs_a) return lat + std::ceil(x * k_tile / bw);
+        return lat + elems_a / bw + (x - reqs_a) * elems_per_b / rate_b;
+    };
+
+    // Issue: `bw` requests per cycle, one tick per rejected attempt; with a
+    // full window the last request waits for reqs - window completions. A
+    // slot freed on a tick is reused in the same cycle, hence the - 1.
+    double issue = std::ceil(reqs / bw) - 1.0;
+    if (window_bound) issue = std::max(issue, std::ceil(completed_by(reqs - window)) - 1.0);
+
+    // Data ready: the completion stream must drain every element, and the
+    // last request issued still needs latency + 1 cycles.
+    double drained = std::ceil(completed_by(reqs)) - (window_bound ? 1.0 : 0.0);
+    double ready = std::max(drained, issue + lat + 1.0);
+
+    const uint64_t compute = tile_compute_cycles(p.dataflow, m_tile, n_tile, k_tile, p.mem_latency);
+    e.memory_backpressure_cycles = static_cast<uint64_t>(std::max(0.0, issue));
+    e.load_cycles = static_cast<uint64_t>(std::max(0.0, ready - issue));
+    e.compute_cycles = compute;
+    e.total_cycles = e.memory_backpressure_cycles + e.load_cycles + compute;
+    e.mac_operations = static_cast<uint64_t>(m_tile) * n_tile * k_tile;
+    e.memory_accesses = static_cast<uint64_t>(elems_a + elems_b);
+    e.tiles = 1;
+    return e;
+}
+
+PerfEstimate estimate_gemm(const PerfModelParams &p, int M, int N, int K) {
+    PerfEstimate total;
+    if (M <= 0 || N <= 0 || K <= 0 || p.array_rows <= 0 || p.array_cols <= 0) return total;
+
+    // Every dimension splits into full tiles plus at most one edge tile, so
+    // the loop has at most eight distinct tile shapes.
+    struct Split { int full_size; uint64_t full; int edge_size; };
+    auto split = [](int dim, int tile) {
+        Split s{tile, static_cast<uint64_t>(dim / tile), dim % tile};
+        return s;
+    };
+    const TileBlocks blk = tile_blocks(p);
+    const Split sm = split(M, blk.m);
+    const Split sn = split(N, blk.n);
+    const Split sk = split(K, blk.k);
+
+    auto shapes = [](const Split &s) {
+        // (size, count) pairs; zero-count entries are skipped by the caller
+        return std::array<std::pair<int, uint64_t>, 2>{{{s.full_size, s.full},
+                                                        {s.edge_size, s.edge_size > 0 ? 1u : 0u}}};
+    };
+    const bool accumulate = p.k_accumulate && p.dataflow == Dataflow::OUTPUT_STATIONARY;
+    for (const auto &mi : shapes(sm)) {
+        for (const auto &ni : shapes(sn)) {
+            if (accumulate && mi.second * ni.second > 0) {
+                // one fill / drain per output tile; the chunks' own schedules are replaced below
+                const uint64_t outputs = mi.second * ni.second;
+                const uint64_t c = tile_compute_cycles(p.dataflow, mi.first, ni.first, K, p.mem_latency) * outputs;
+                total.total_cycles += c;
+                total.compute_cycles += c;
+            }
+            for (const auto &ki : shapes(sk)) {
+                uint64_t count = mi.second * ni.second * ki.second;
+                if (count == 0) continue;
+                PerfEstimate t = estimate_tile(p, mi.first, ni.first, ki.first);
+                if (accumulate) {
+                    t.total_cycles -= t.compute_cycles;
+                    t.compute_cycles = 0;
+                }
+                total.total_cycles += t.total_cycles * count;
+                total.compute_cycles += t.compute_cycles * count;
+                total.load_cycles += t.load_cycles * count;
+                total.memory_backpressure_cycles += t.memory_backpressure_cycles * count;
+                total.mac_operations += t.mac_operations * count;
+                total.memory_accesses += t.memory_accesses * count;
+                total.tiles += count;
+            }
+        }
+    }
+    return total;
+}
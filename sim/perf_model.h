@@ -0,0 +1,71 @@
+// perf_model.h — 解析式性能模型（中文注释）
+// 对 `SystolicArray::run` 的 tile 循环给出闭式周期估计：每个 tile 的
+// 预取（发射带宽 / max_outstanding 窗口 / 完成带宽 / 访存延迟）加上
+// 斜向填充与排空的计算阶段（k_tile + m_tile + n_tile + latency，
+// 权重 / 输入驻留数据流另加 k_tile 个预装载周期）。
+// 相同形状的 tile 只计算一次再乘以个数，耗时与矩阵规模无关（微秒级），
+// 用于设计空间探索；逐周期精度请使用 Fidelity::CYCLE。
+// 分 bank 内存（memory.banked）的行缓冲与 bank 冲突、定时结果回写（cube.timed_writeback）
+// 与预取前瞻（cube.prefetch_depth）不在模型内，按平坦延迟、零代价回写、串行预取估计。
+#ifndef PERF_MODEL_H
+#define PERF_MODEL_H
+
+#include <cstdint>
+
+#include "types.h"
+
+struct PerfModelParams {
+    int array_rows = 8;
+    int array_cols = 8;
+    int mem_latency = 10;
+    int bandwidth = 4;        // 每周期发射请求数 / 完成元素数
+    int max_outstanding = 40; // 未完成请求窗口
+    bool b_descriptor = true; // B 子块作为一个 2D 描述符请求（否则逐元素）
+    Dataflow dataflow = Dataflow::OUTPUT_STATIONARY;
+    // Tile extents along M / N / K (0: the dataflow's default, see tile_blocks)
+    int tile_m = 0;
+    int tile_n = 0;
+    int tile_k = 0;
+    bool k_accumulate = false; // output-stationary: K chunks of an output tile stream back to back
+};
+
+// GEMM blocking of a dataflow: how many rows of M, columns of N and steps of
+// K one tile covers. The array dimensions bound the operands held in it
+// (output-stationary: the m x n outputs; weight-stationary: the k x n
+// weights; input-stationary: the k x m inputs); the streamed dimension is
+// free and defaults to the array size along the same edge. Requested
+// extents (tile_m / tile_n / tile_k) are clamped to those bounds. With
+// k_accumulate the output-stationary K block is at least as deep as the
+// tile is wide, so a row or column never lags more than one chunk behind.
+struct TileBlocks {
+    int m;
+    int n;
+    int k;
+};
+TileBlocks tile_blocks(const PerfModelParams &p);
+
+// Array cycles of one tile's compute schedule: skewed fill, stream and drain
+// plus the fixed result latency, and for the stationary dataflows the
+// k_tile cycles that shift the stationary operand into place.
+uint64_t tile_compute_cycles(Dataflow dataflow, int m_tile, int n_tile, int k_tile, int mem_latency);
+
+struct PerfEstimate {
+    uint64_t total_cycles = 0;
+    uint64_t compute_cycles = 0;
+    uint64_t load_cycles = 0;                // prefetch 等待周期
+    uint64_t memory_backpressure_cycles = 0; // 发射被拒绝的周期
+    uint64_t mac_operations = 0;             // 上界 M*N*K（不看数据是否为 0）
+    uint64_t memory_accesses = 0;
+    uint64_t tiles = 0;
+};
+
+// Prefetch + compute estimate for one m_tile x n_tile x k_tile tile.
+PerfEstimate estimate_tile(const PerfModelParams &p, int m_tile, int n_tile, int k_tile);
+
+// Whole GEMM over the tile loop used by SystolicArray::run (any loop order:
+// without a buffer model the sum does not depend on it). With k_accumulate
+// an output-stationary output tile pays fill, drain and result latency once
+// over all of K, its later chunks only their loads.
+PerfEstimate estimate_gemm(const PerfModelParams &p, int M, int N, int K);
+
+#endif // PERF_MODEL_H
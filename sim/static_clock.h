@@ -0,0 +1,82 @@
+// static_clock.h — 编译期组件图时钟（中文注释）
+// `StaticClock<Stages...>` 在编译期固定各阶段的执行顺序（模板参数顺序即优先级），
+// 每个阶段的 `cycle()` 直接内联调用，没有 std::function 类型擦除。
+// 适用于固定流水线（如 Mem→PE→commit→controller）；临时/动态监听器仍使用 `Clock`。
+// 整个 StaticClock 也可以作为单个监听器挂到动态 `Clock` 上（见 SystolicArray）。
+//
+// 阶段类型需提供 `void cycle()`；可选提供：
+//   `void skip(Cycle n)`                 — 事件驱动模式下批量结算 n 个空闲周期
+//   `Cycle cycles_until_event() const`   — 距下一次需要真实 tick 的周期数（UINT64_MAX 表示空闲）
+#ifndef STATIC_CLOCK_H
+#define STATIC_CLOCK_H
+
+#include <algorithm>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "types.h"
+
+namespace static_clock_detail {
+
+template<typename T, typename = void>
+struct has_skip : std::false_type {};
+template<typename T>
+struct has_skip<T, std::void_t<decltype(std::declval<T&>().skip(Cycle{}))>> : std::true_type {};
+
+template<typename T, typename = void>
+struct has_next_event : std::false_type {};
+template<typename T>
+struct has_next_event<T, std::void_t<decltype(std::declval<const T&>().cycles_until_event())>> : std::true_type {};
+
+} // namespace static_clock_detail
+
+template<typename... Stages>
+class StaticClock {
+public:
+    StaticClock() : cycle_count(0) {}
+    explicit StaticClock(Stages... stages) : stages_(std::move(stages)...), cycle_count(0) {}
+
+    // Advance one cycle: every stage's cycle() in template-argument order.
+    void tick() {
+        cycle_count++;
+        std::apply([](auto &... s) { (s.cycle(), ...); }, stages_);
+    }
+
+    // Account for `n` idle cycles on the stages that support skipping.
+    void skip(Cycle n) {
+        cycle_count += n;
+        std::apply([n](auto &... s) { (skip_one(s, n), ...); }, stages_);
+    }
+
+    // Cycles until the earliest stage needs a real tick (UINT64_MAX if none does).
+    Cycle cycles_until_event() const {
+        Cycle earliest = UINT64_MAX;
+        std::apply([&earliest](const auto &... s) { ((earliest = std::min(earliest, next_event_of(s))), ...); }, stages_);
+        return earliest;
+    }
+
+    Cycle now() const { return cycle_count; }
+
+    template<std::size_t I>
+    auto &stage() { return std::get<I>(stages_); }
+
+private:
+    std::tuple<Stages...> stages_;
+    Cycle cycle_count;
+
+    template<typename S>
+    static void skip_one(S &s, Cycle n) {
+        if constexpr (static_clock_detail::has_skip<S>::value) s.skip(n);
+        else (void)n;
+    }
+
+    template<typename S>
+    static Cycle next_event_of(const S &s) {
+        if constexpr (static_clock_detail::has_next_event<S>::value) return s.cycles_until_event();
+        else { (void)s; return UINT64_MAX; }
+    }
+};
+
+#endif // STATIC_CLOCK_H
@@ -1,13 +1,17 @@
 #include "systolic.h"
 #include "clock.h"
 #include "config/config.h"
+#include "util/snapshot.h"
+#include "util/gemm.h"
 #include <iostream>
 #include "util/log.h"
 #include <fstream>
 #include <iomanip>
 #include <cassert>
+#include <algorithm>
 #include <cmath>
 #include <map>
+#include <random>
 #include <stdexcept>
 
 // Implementations for PE and Mem have been
@@ -18,92 +22,209 @@
 // (or `Cube::run` which now wraps the memory-driven path) to execute matrix
 // multiplication using the memory model.
 
-bool SystolicArray::issue_prefetch_for_tile(int mb, int nb, int kb, int m_tile, int n_tile, int k_tile,
-                                            int A_cols, int B_cols,
-                                            uint32_t a_addr, uint32_t b_addr,
-                                            std::vector<FIFO>& localA_pool,
-                                            std::vector<FIFO>& localB_pool,
-                                            std::vector<std::shared_ptr<std::deque<DataType>>>& completionA,
-                                            std::vector<std::shared_ptr<std::deque<DataType>>>& completionB,
-                                            size_t queue_depth) {
-    for (int i = 0; i < m_tile; ++i) { completionA[i] = completionA_pool[i]; completionA[i]->clear(); }
-    for (int j = 0; j < n_tile; ++j) { completionB[j] = completionB_pool[j]; completionB[j]->clear(); }
-
-    // Issue row bursts for A
-    for (int i = 0; i < m_tile; ++i) {
-        // Address each A row using full row stride A_cols (which equals K)
-        uint32_t addr = static_cast<uint32_t>((mb + i) * A_cols + kb) + a_addr;
-        while (!memory->read_request(addr, completionA[i], queue_depth, static_cast<size_t>(k_tile))) {
-            stats.memory_backpressure_cycles++;
-            if (clock) clock->tick();
-        }
-        stats.memory_accesses += static_cast<uint64_t>(k_tile);
+bool SystolicArray::issue_prefetch_for_tile(int gemm, int mb, int nb, int kb, bool lookahead) {
+    // Completions land directly in the FIFOs of a free set through the
+    // streams registered for them at construction. A banked Mem resolves
+    // bank timing at issue, so the per-operand bank stats are exact deltas.
+    // A tile resident in the local buffer is pushed into the FIFOs right away
+    // but only counts as arrived once the buffer's read ports have moved it
+    // (wait_for_prefetch holds on its buffer_ready_cycle); a missing one is
+    // read from memory and captured by fill_local_buffer after it has landed.
+    int set = 0;
+    while (set < static_cast<int>(fifo_sets.size()) &&
+           std::any_of(tile_loads.begin(), tile_loads.end(), [set](const TileLoad &l) { return l.set == set; })) {
+        set++;
+    }
+    const int b_channel = std::min(1, dma->channels() - 1);
+    if (lookahead && (set == static_cast<int>(fifo_sets.size()) || dma->channel_full(0) || dma->channel_full(b_channel))) {
+        return false;
     }
 
-    // Issue reads for B (per element per column across k_tile)
-    for (int kk = 0; kk < k_tile; ++kk) {
-        int k_idx = kb + kk;
-        for (int j = 0; j < n_tile; ++j) {
-            // B element at (k_idx, nb+j) with row stride B_cols (which equals N)
-            uint32_t addrB = static_cast<uint32_t>(k_idx * B_cols + (nb + j)) + b_addr;
-            while (!memory->read_request(addrB, completionB[j], queue_depth)) {
-                stats.memory_backpressure_cycles++;
-                if (clock) clock->tick();
-            }
-            stats.memory_accesses++;
+    const GemmDesc &g = batch[static_cast<size_t>(gemm)];
+    const int A_cols = g.lda, B_cols = g.ldb;
+    const int m_tile = std::min(blocks.m, g.M - mb);
+    const int n_tile = std::min(blocks.n, g.N - nb);
+    const int k_tile = std::min(blocks.k, g.K - kb);
+    FifoSet &fifos = fifo_sets[static_cast<size_t>(set)];
+    if (a_by_row()) for (int i = 0; i < m_tile; ++i) fifos.a[i].reset(k_tile + 4);
+    else for (int kk = 0; kk < k_tile; ++kk) fifos.a[kk].reset(m_tile + 4);
+    if (b_by_col()) for (int j = 0; j < n_tile; ++j) fifos.b[j].reset(k_tile + 4);
+    else for (int kk = 0; kk < k_tile; ++kk) fifos.b[kk].reset(n_tile + 4);
+    tile_loads.push_back(TileLoad{gemm, mb, nb, kb, m_tile, n_tile, k_tile, set, 0, 0, 0, 0, false, false});
+    TileLoad &load = tile_loads.back();
+
+    const LocalBuffer::Key key_a{LocalBuffer::kOperandA,
+                                 g.a_addr + static_cast<Addr>(mb) * static_cast<Addr>(A_cols) + static_cast<Addr>(kb),
+                                 static_cast<uint32_t>(m_tile), static_cast<uint32_t>(k_tile), static_cast<Addr>(A_cols)};
+    const LocalBuffer::Key key_b{LocalBuffer::kOperandB,
+                                 g.b_addr + static_cast<Addr>(kb) * static_cast<Addr>(B_cols) + static_cast<Addr>(nb),
+                                 static_cast<uint32_t>(k_tile), static_cast<uint32_t>(n_tile), static_cast<Addr>(B_cols)};
+    const std::vector<DataType> *hit_a = local_buffer ? local_buffer->lookup(key_a) : nullptr;
+    const std::vector<DataType> *hit_b = local_buffer ? local_buffer->lookup(key_b) : nullptr;
+    if (local_buffer) {
+        const Cycle now = clock ? clock->now() : current_cycle;
+        for (const std::vector<DataType> *hit : {hit_a, hit_b}) {
+            if (!hit) continue;
+            load.buffer_ready_cycle = std::max(load.buffer_ready_cycle, local_buffer->transfer(now, hit->size()));
+            stats.buffer_hits++;
+            stats.buffer_saved_elems += hit->size();
         }
+        stats.buffer_misses += (hit_a ? 0 : 1) + (hit_b ? 0 : 1);
+        load.fill_a = !hit_a;
+        load.fill_b = !hit_b;
+    }
+    if (hit_a) {
+        for (int i = 0; i < m_tile; ++i)
+            for (int kk = 0; kk < k_tile; ++kk)
+                fifos.a[a_by_row() ? i : kk].push((*hit_a)[static_cast<size_t>(i) * k_tile + kk]);
+    }
+    if (hit_b) {
+        for (int kk = 0; kk < k_tile; ++kk)
+            for (int j = 0; j < n_tile; ++j)
+                fifos.b[b_by_col() ? j : kk].push((*hit_b)[static_cast<size_t>(kk) * n_tile + j]);
+    }
+
+    // Queue the tile's loads on the DMA engine: A rows on channel 0 as one
+    // k_tile burst per row, the B sub-block on channel 1 (if there is one) as
+    // a single 2D request, or element by element with
+    // cube.prefetch_descriptors = false. Each operand's streams were
+    // registered back to back, so their ids are consecutive and the stream
+    // steps spread the elements over the FIFOs of the dataflow's layout.
+    if (!hit_a) {
+        DmaEngine::Descriptor desc;
+        desc.src = static_cast<Addr>(mb) * static_cast<Addr>(A_cols) + static_cast<Addr>(kb) + g.a_addr;
+        desc.count = static_cast<uint32_t>(k_tile);
+        desc.stride = static_cast<Addr>(A_cols);
+        desc.repeat = static_cast<uint32_t>(m_tile);
+        desc.stream = fifos.stream_a;
+        desc.stream_row_step = a_by_row() ? 1 : 0;
+        desc.stream_col_step = a_by_row() ? 0 : 1;
+        desc.burst = static_cast<uint32_t>(k_tile);
+        submit_dma(0, desc, load, load.a_id);
+        stats.memory_accesses += static_cast<uint64_t>(m_tile) * static_cast<uint64_t>(k_tile);
+    }
+    if (!hit_b) {
+        DmaEngine::Descriptor desc;
+        desc.src = static_cast<Addr>(kb) * static_cast<Addr>(B_cols) + static_cast<Addr>(nb) + g.b_addr;
+        desc.count = static_cast<uint32_t>(n_tile);
+        desc.stride = static_cast<Addr>(B_cols);
+        desc.repeat = static_cast<uint32_t>(k_tile);
+        desc.stream = fifos.stream_b;
+        desc.stream_row_step = b_by_col() ? 0 : 1;
+        desc.stream_col_step = b_by_col() ? 1 : 0;
+        desc.burst = cfg_prefetch_descriptors ? 0 : 1;
+        submit_dma(b_channel, desc, load, load.b_id);
+        stats.memory_accesses += static_cast<uint64_t>(k_tile) * static_cast<uint64_t>(n_tile);
     }
     return true;
 }
 
-bool SystolicArray::wait_for_prefetch(int m_tile, int n_tile, int k_tile,
-                                     std::vector<FIFO>& localA_pool,
-                                     std::vector<FIFO>& localB_pool) {
-    int max_wait = 10000;
-    int waited = 0;
-    while (waited < max_wait) {
-        // drain completion queues into FIFO pools (completion queues are attached to local FIFOs by caller)
-        for (int i = 0; i < m_tile; ++i) {
-            auto &q = completionA_pool[i];
-            while (q && !q->empty() && !localA_pool[i].full()) {
-                DataType v = q->front(); q->pop_front(); localA_pool[i].push(v);
-            }
-        }
-        for (int j = 0; j < n_tile; ++j) {
-            auto &q = completionB_pool[j];
-            while (q && !q->empty() && !localB_pool[j].full()) {
-                DataType v = q->front(); q->pop_front(); localB_pool[j].push(v);
-            }
+// Queue one transfer; a full channel holds the controller until one of its
+// transfers completes.
+void SystolicArray::submit_dma(int channel, const DmaEngine::Descriptor &desc, TileLoad &load, uint32_t &id) {
+    load.pending++;
+    while ((id = dma->submit(channel, desc)) == 0) {
+        stats.memory_backpressure_cycles += advance();
+    }
+    if (dma->done(id)) load.pending--;
+}
+
+// With cube.prefetch_depth > 0, keep the loads of up to that many tiles
+// after the current one (in loop order, on into the next GEMM of a batch)
+// in flight in the shadow FIFO sets, so they land while the array computes;
+// `limit` counts every entry of tile_loads, including a held previous K
+// chunk. Sampled runs jump between tiles and issue nothing ahead.
+void SystolicArray::issue_lookahead(size_t limit) {
+    if (cfg_prefetch_depth <= 0 || cfg_fidelity == Fidelity::SAMPLED) return;
+    while (!tile_loads.empty() && tile_loads.size() < limit) {
+        const TileLoad &last = tile_loads.back();
+        int gemm = last.gemm, mb = last.mb, nb = last.nb, kb = last.kb;
+        if (!next_tile_position(batch[static_cast<size_t>(gemm)], mb, nb, kb)) {
+            if (++gemm == static_cast<int>(batch.size())) return;
+            mb = nb = kb = 0;
         }
-        bool ready = true;
-        for (int i = 0; i < m_tile; ++i) if (localA_pool[i].count < k_tile) { ready = false; break; }
-        for (int j = 0; j < n_tile && ready; ++j) if (localB_pool[j].count < k_tile) { ready = false; break; }
-        if (ready) return true;
-        if (clock) clock->tick();
-        waited++;
+        if (!issue_prefetch_for_tile(gemm, mb, nb, kb, true)) return;
+    }
+}
+
+bool SystolicArray::lookahead_in_flight() const {
+    for (size_t i = 1; i < tile_loads.size(); ++i) {
+        if (tile_loads[i].pending > 0) return true;
     }
     return false;
 }
 
-bool SystolicArray::process_tile(std::vector<FIFO>& localA_pool,
-                                             std::vector<FIFO>& localB_pool,
-                                             int mb, int nb, int m_tile, int n_tile, int k_tile,
-                                             uint32_t c_addr, int N) {
+// Drop loads issued for tiles the run did not go on to (only after the tile
+// order changed under them); their transfers are waited out first.
+void SystolicArray::discard_tile_loads() {
+    while (std::any_of(tile_loads.begin(), tile_loads.end(), [](const TileLoad &l) { return l.pending > 0; })) {
+        stats.load_cycles += advance();
+    }
+    tile_loads.clear();
+}
+
+// Wait until the current tile's DMA transfers have completed (and anything
+// served by the local buffer has been moved). Cycles in which the DMA engine
+// still had requests that Mem would not accept are memory backpressure, the
+// rest are load wait; the timeout budget only covers the latter.
+bool SystolicArray::wait_for_prefetch(const TileLoad &load) {
+    const int max_wait = 10000;
+    const uint64_t stall_start = dma->stall_cycles();
+    uint64_t waited = 0, stalled = 0;
+    bool ready = false;
+    while (waited - stalled < static_cast<uint64_t>(max_wait)) {
+        const Cycle now = clock->now();
+        if (load.pending == 0 && now >= load.buffer_ready_cycle) {
+            ready = true;
+            break;
+        }
+        // Nothing can land before the next memory or DMA event or the end of
+        // the local buffer transfer; in event-driven mode the clock jumps
+        // straight there (bounded by the remaining wait budget).
+        Cycle limit = static_cast<Cycle>(max_wait) - (waited - stalled);
+        if (now < load.buffer_ready_cycle) limit = std::min(limit, load.buffer_ready_cycle - now);
+        waited += advance(limit);
+        stalled = dma->stall_cycles() - stall_start;
+    }
+    if (waited == 0) stats.prefetch_ready_tiles++;
+    stats.memory_backpressure_cycles += stalled;
+    stats.load_cycles += waited - stalled;
+    return ready;
+}
+
+// Account for `n` idle cycles skipped by an event-driven Clock.
+void SystolicArray::skip_cycles(Cycle n) {
+    stats.total_cycles += n;
+    // Nothing completes inside a skipped stretch, so the pending state is constant.
+    if (memory && memory->has_pending()) {
+        stats.memory_stall_cycles += n;
+    }
+    current_cycle += n;
+}
+
+bool SystolicArray::process_tile(const TileLoad &load, const TileLoad *prev) {
     // Initialize PE state for this tile, execute scheduled cycles, then commit results
-    init_tile_state(m_tile, n_tile);
-    if (!execute_tile_cycles(localA_pool, localB_pool, m_tile, n_tile, k_tile)) return false;
-    commit_tile_results(mb, nb, m_tile, n_tile, c_addr, N);
+    FifoSet &fifos = fifo_sets[static_cast<size_t>(load.set)];
+    const int m_tile = load.m_tile, n_tile = load.n_tile, k_tile = load.k_tile;
+    const bool first = !accumulate_k() || load.kb == 0;
+    const bool last = !accumulate_k() || load.kb + k_tile >= run_pos.K;
+    if (cfg_dataflow_cached == Dataflow::OUTPUT_STATIONARY) {
+        if (first) init_tile_state(m_tile, n_tile);
+        const bool ok = accumulate_k()
+                            ? execute_accumulating_chunk(prev ? &fifo_sets[static_cast<size_t>(prev->set)] : nullptr,
+                                                         fifos, load.kb, m_tile, n_tile, k_tile)
+                            : execute_tile_cycles(fifos.a, fifos.b, m_tile, n_tile, k_tile);
+        if (!ok) return false;
+    } else if (!execute_stationary_tile(fifos.a, fifos.b, m_tile, n_tile, k_tile, !first)) {
+        return false;
+    }
+    if (last) commit_tile_results(load.mb, load.nb, m_tile, n_tile, run_pos.c_addr, run_pos.ldc);
     return true;
 }
 
 // Initialize per-PE state (accumulator and activation) for a tile
 void SystolicArray::init_tile_state(int m_tile, int n_tile) {
-    for (int i = 0; i < m_tile; ++i) {
-        for (int j = 0; j < n_tile; ++j) {
-            pes[i][j].set_accumulator(0);
-            pes[i][j].set_activation(0);
-        }
-    }
+    grid.begin_tile(m_tile, n_tile);
 }
 
 // Execute the cycle schedule for a tile using provided local FIFOs
@@ -111,11 +232,15 @@ bool SystolicArray::execute_tile_cycles(std::vector<FIFO>& localA_pool,
                                        std::vector<FIFO>& localB_pool,
                                        int m_tile, int n_tile, int k_tile) {
     int mem_lat = memory ? memory->get_latency() : 0;
-    int total_cycles = k_tile + m_tile + n_tile + mem_lat;
+    int total_cycles = static_cast<int>(tile_compute_cycles(Dataflow::OUTPUT_STATIONARY, m_tile, n_tile, k_tile, mem_lat));
+    // From this cycle on every activation entering the array is zero, so the
+    // accumulators are a fixed point and the remaining cycles are pure drain.
+    int drain_start = k_tile + m_tile + n_tile - 2;
     std::vector<DataType> left_in(m_tile, 0);
     std::vector<DataType> top_in(n_tile, 0);
+    std::vector<char> top_valid(n_tile, 0);
 
-    for (int t = 0; t < total_cycles; ++t) {
+    for (int t = 0; t < total_cycles; ) {
         for (int i = 0; i < m_tile; ++i) left_in[i] = 0;
         for (int j = 0; j < n_tile; ++j) top_in[j] = 0;
 
@@ -126,8 +251,8 @@ bool SystolicArray::execute_tile_cycles(std::vector<FIFO>& localA_pool,
                 if (localA_pool[i].pop(v)) left_in[i] = v;
             }
         }
-        std::vector<char> top_valid(n_tile, 0);
         for (int j = 0; j < n_tile; ++j) {
+            top_valid[j] = 0;
             int kk_required = t - j;
             if (kk_required >= 0 && kk_required < k_tile) {
                 DataType v;
@@ -135,123 +260,951 @@ bool SystolicArray::execute_tile_cycles(std::vector<FIFO>& localA_pool,
             }
         }
 
+        // Stage the whole array's inputs in one pass; the clock's PE tick and
+        // commit listeners then update every PE at once.
+        stats.mac_operations += grid.prepare(left_in.data(), top_in.data(), top_valid.data());
+
+        // The inputs prepared for the first drain cycle stay valid for the rest
+        // of the drain, so an event-driven clock may skip those cycles.
+        Cycle limit = (t >= drain_start) ? static_cast<Cycle>(total_cycles - t) : 1;
+        const bool overlapped = cfg_prefetch_depth > 0 && lookahead_in_flight();
+        Cycle elapsed = clock ? advance(limit) : 1;
+        stats.compute_cycles += elapsed;
+        if (overlapped) stats.prefetch_overlap_cycles += elapsed;
+        t += static_cast<int>(elapsed);
+    }
+    return true;
+}
+
+// One K chunk of an output-stationary output tile under K accumulation. The
+// chunks form one continuous stream: row i takes A element kk at step
+// kk + i of the output tile and column j takes B element kk at step kk + j,
+// so the chunk starting at kb owns steps [kb, kb + k_tile) of the schedule
+// and the rows and columns lagging behind row 0 still finish the previous
+// chunk from its FIFO set (never further back: the K block is at least as
+// deep as the tile is wide). Only the last chunk runs the drain and the
+// result latency. Between chunks the grid is simply not armed, so waiting
+// for a late chunk freezes the wavefront in place.
+bool SystolicArray::execute_accumulating_chunk(FifoSet *prev, FifoSet &cur,
+                                              int kb, int m_tile, int n_tile, int k_tile) {
+    const int K = run_pos.K;
+    if (kb > 0 && !prev) {
+        LOG_ERROR("run: previous K chunk of the output tile is not loaded");
+        return false;
+    }
+    const int mem_lat = memory ? memory->get_latency() : 0;
+    const bool last = kb + k_tile >= K;
+    const int end = last ? static_cast<int>(tile_compute_cycles(Dataflow::OUTPUT_STATIONARY, m_tile, n_tile, K, mem_lat))
+                         : kb + k_tile;
+    const int drain_start = K + m_tile + n_tile - 2;
+    std::vector<DataType> left_in(m_tile, 0);
+    std::vector<DataType> top_in(n_tile, 0);
+    std::vector<char> top_valid(n_tile, 0);
+
+    for (int t = kb; t < end; ) {
         for (int i = 0; i < m_tile; ++i) {
-            for (int j = 0; j < n_tile; ++j) {
-                DataType act_in = 0;
-                AccType psum_in = 0;
-                DataType weight_in = 0;
-                bool weight_present = false;
-                if (j > 0) act_in = pes[i][j-1].get_activation(); else act_in = left_in[i];
-                psum_in = pes[i][j].get_accumulator();
-                if (i > 0) {
-                    weight_in = pes[i-1][j].get_weight();
-                    weight_present = pes[i-1][j].has_weight();
-                } else {
-                    weight_in = top_in[j];
-                    weight_present = top_valid[j];
-                }
-                pes[i][j].prepare_inputs(act_in, psum_in, weight_in, weight_present);
-                if (pes[i][j].has_weight() && act_in != 0) stats.mac_operations++;
+            left_in[i] = 0;
+            const int kk = t - i;
+            DataType v;
+            if (kk >= 0 && kk < K && (kk < kb ? prev->a[i] : cur.a[i]).pop(v)) left_in[i] = v;
+        }
+        for (int j = 0; j < n_tile; ++j) {
+            top_in[j] = 0;
+            top_valid[j] = 0;
+            const int kk = t - j;
+            DataType v;
+            if (kk >= 0 && kk < K && (kk < kb ? prev->b[j] : cur.b[j]).pop(v)) {
+                top_in[j] = v;
+                top_valid[j] = 1;
             }
         }
+        stats.mac_operations += grid.prepare(left_in.data(), top_in.data(), top_valid.data());
 
-        if (clock) clock->tick();
-        stats.compute_cycles++;
+        Cycle limit = (t >= drain_start) ? static_cast<Cycle>(end - t) : 1;
+        const bool overlapped = cfg_prefetch_depth > 0 && lookahead_in_flight();
+        Cycle elapsed = clock ? advance(limit) : 1;
+        stats.compute_cycles += elapsed;
+        if (overlapped) stats.prefetch_overlap_cycles += elapsed;
+        t += static_cast<int>(elapsed);
     }
     return true;
 }
 
-// Commit accumulators for a tile into memory at base address c_addr (row stride N)
+// Weight- and input-stationary schedule. Both keep one operand in the PE
+// weight registers and stream the other through the array:
+//   * weight-stationary: B[kk][j] sits in PE(kk, j); A[i][kk] enters row kk
+//     (skewed by i) and C[i][j] leaves the bottom of column j;
+//   * input-stationary: A[i][kk] sits in PE(kk, i); B[kk][j] enters row kk
+//     (skewed by j) and C[i][j] leaves the bottom of column i.
+// The stationary operand is first shifted down from the top edge, deepest
+// row first (k_tile preload cycles). Partial sums then move down one row per
+// cycle, so the sum for stream index s in column c is complete after cycle
+// s + (k_tile - 1) + c; once the last one is out only the fixed tail remains.
+bool SystolicArray::execute_stationary_tile(std::vector<FIFO>& localA_pool,
+                                           std::vector<FIFO>& localB_pool,
+                                           int m_tile, int n_tile, int k_tile, bool add_to_out) {
+    const bool ws = cfg_dataflow_cached == Dataflow::WEIGHT_STATIONARY;
+    std::vector<FIFO> &held = ws ? localB_pool : localA_pool;     // one FIFO per column, k_tile deep
+    std::vector<FIFO> &streamed = ws ? localA_pool : localB_pool; // one FIFO per array row
+    const int cols = ws ? n_tile : m_tile;
+    const int stream_len = ws ? m_tile : n_tile;
+    auto peek = [](const FIFO &f, int n) { return f.buffer[static_cast<size_t>((f.read_ptr + n) % f.depth)]; };
+
+    grid.begin_tile(k_tile, cols);
+    if (!add_to_out) tile_out.assign(static_cast<size_t>(m_tile) * n_tile, 0);
+    std::vector<DataType> left_in(static_cast<size_t>(k_tile), 0);
+    std::vector<DataType> top_in(static_cast<size_t>(cols), 0);
+    std::vector<char> top_valid(static_cast<size_t>(cols), 1);
+
+    grid.set_preload(true);
+    for (int p = 0; p < k_tile; ) {
+        for (int c = 0; c < cols; ++c) top_in[c] = peek(held[c], k_tile - 1 - p);
+        grid.prepare(left_in.data(), top_in.data(), top_valid.data());
+        Cycle elapsed = clock ? advance(1) : 1;
+        stats.compute_cycles += elapsed;
+        stats.preload_cycles += elapsed;
+        p += static_cast<int>(elapsed);
+    }
+    grid.set_preload(false);
+    for (int c = 0; c < cols; ++c) held[c].reset(held[c].depth);
+    std::fill(top_valid.begin(), top_valid.end(), 0);
+
+    const int mem_lat = memory ? memory->get_latency() : 0;
+    const int total_cycles = static_cast<int>(tile_compute_cycles(cfg_dataflow_cached, m_tile, n_tile, k_tile, mem_lat)) - k_tile;
+    const int last_out = stream_len - 1 + k_tile - 1 + cols - 1;
+    for (int t = 0; t < total_cycles; ) {
+        for (int r = 0; r < k_tile; ++r) {
+            left_in[r] = 0;
+            const int s = t - r;
+            DataType v;
+            if (s >= 0 && s < stream_len && streamed[r].pop(v)) left_in[r] = v;
+        }
+        stats.mac_operations += grid.prepare(left_in.data(), top_in.data(), top_valid.data());
+
+        // After the last sum has left the array nothing changes any more, so
+        // an event-driven clock may skip the tail.
+        const bool overlapped = cfg_prefetch_depth > 0 && lookahead_in_flight();
+        Cycle limit = (t > last_out) ? static_cast<Cycle>(total_cycles - t) : 1;
+        Cycle elapsed = clock ? advance(limit) : 1;
+        stats.compute_cycles += elapsed;
+        if (overlapped) stats.prefetch_overlap_cycles += elapsed;
+        if (t <= last_out) {
+            for (int c = 0; c < cols; ++c) {
+                const int s = t - (k_tile - 1) - c;
+                if (s < 0 || s >= stream_len) continue;
+                const AccType v = grid.accumulator(k_tile - 1, c);
+                tile_out[ws ? static_cast<size_t>(s) * n_tile + c : static_cast<size_t>(c) * n_tile + s] += v;
+            }
+        }
+        t += static_cast<int>(elapsed);
+    }
+    return true;
+}
+
+// Commit accumulators for a tile into memory at base address c_addr (row stride ldc).
+// With cube.timed_writeback each tile row goes through the write-combining
+// buffer and Mem's write path instead of landing instantly.
 void SystolicArray::commit_tile_results(int mb, int nb, int m_tile, int n_tile,
-                                      uint32_t c_addr, int N) {
+                                      Addr c_addr, int ldc) {
+    const bool timed = cfg_timed_writeback && memory;
+    std::vector<AccType> row(timed ? static_cast<size_t>(n_tile) : 0);
     for (int i = 0; i < m_tile; ++i) {
+        const Addr row_addr = c_addr + static_cast<Addr>(mb + i) * static_cast<Addr>(ldc) + static_cast<Addr>(nb);
         for (int j = 0; j < n_tile; ++j) {
-            int idx = (mb + i) * N + (nb + j);
-            AccType val = pes[i][j].get_accumulator();
-            if (memory) memory->store_acc_direct(static_cast<uint32_t>(c_addr + idx), val);
+            AccType val = tile_result(i, j, n_tile);
+            if (timed) row[static_cast<size_t>(j)] = val;
+            else if (memory) memory->store_acc_direct(row_addr + static_cast<Addr>(j), val);
             if (cfg_verbose && m_tile <= 4 && n_tile <= 4) {
                 LOG_INFO("Commit C({},{}) += {}", (mb+i), (nb+j), val);
             }
         }
+        if (timed) enqueue_writeback(row_addr, row.data(), n_tile);
+    }
+    if (timed && !cfg_drain_overlap) flush_writeback();
+}
+
+// Merge a tile row into the tail burst when it continues it (rows of a
+// full-width C block are contiguous), else open a new entry. A full buffer
+// stalls the array until the write-back stage has issued its head.
+void SystolicArray::enqueue_writeback(Addr addr, const AccType *vals, int len) {
+    if (!wcb.empty()) {
+        WriteBurst &tail = wcb.back();
+        if (tail.addr + tail.vals.size() == addr &&
+            tail.vals.size() + static_cast<size_t>(len) <= static_cast<size_t>(cfg_wcb_burst)) {
+            tail.vals.insert(tail.vals.end(), vals, vals + len);
+            return;
+        }
+    }
+    while (static_cast<int>(wcb.size()) >= cfg_wcb_entries) stats.drain_cycles += advance();
+    wcb.push_back(WriteBurst{addr, std::vector<AccType>(vals, vals + len)});
+}
+
+void SystolicArray::issue_writeback() {
+    while (!wcb.empty()) {
+        const WriteBurst &b = wcb.front();
+        if (!memory->acc_write_request(b.addr, b.vals.data(), b.vals.size(), write_sink)) break;
+        writes_in_flight += b.vals.size();
+        stats.writeback_bursts++;
+        stats.memory_accesses += b.vals.size();
+        wcb.pop_front();
+    }
+}
+
+Cycle SystolicArray::writeback_wake() const {
+    // A full outstanding window frees up on a Mem completion, which wakes the clock anyway.
+    return wcb.empty() || memory->outstanding_full() ? UINT64_MAX : 1;
+}
+
+// Wait until every queued result has been issued and written. Only this
+// array's writes count: reads in flight (prefetch) and other requesters on a
+// shared Mem are not waited for.
+void SystolicArray::flush_writeback() {
+    while (!wcb.empty() || writes_in_flight > 0) {
+        stats.drain_cycles += advance();
     }
 }
 
 bool SystolicArray::run(int M, int N, int K,
-                                   uint32_t a_addr, uint32_t b_addr, uint32_t c_addr) {
-    // Similar to run(...), but inputs A/B are read from memory at provided
-    // base addresses and results are written back into accumulator memory
-    // starting at c_addr via Mem::store_acc_direct.
-
-    // Basic checks
-    if (K <= 0 || M <= 0 || N <= 0) {
-        LOG_ERROR("run: invalid dimensions");
+                                   Addr a_addr, Addr b_addr, Addr c_addr) {
+    // Inputs A/B are read from memory at the provided base addresses and
+    // results are written back into accumulator memory starting at c_addr
+    // via Mem::store_acc_direct.
+    if (cfg_fidelity == Fidelity::ANALYTICAL) return set_batch({GemmDesc{M, N, K}}) && run_analytical();
+    if (cfg_fidelity == Fidelity::FUNCTIONAL) {
+        return set_batch({GemmDesc{M, N, K, a_addr, b_addr, c_addr}}) && run_functional();
+    }
+    if (cfg_fidelity == Fidelity::SAMPLED) return run_sampled(M, N, K, a_addr, b_addr, c_addr);
+    if (!begin_run(M, N, K, a_addr, b_addr, c_addr)) return false;
+    return resume();
+}
+
+PerfModelParams SystolicArray::perf_model_params() const {
+    PerfModelParams p;
+    p.array_rows = cfg_array_rows;
+    p.array_cols = cfg_array_cols;
+    p.mem_latency = memory->get_latency();
+    p.bandwidth = memory->get_bandwidth();
+    p.max_outstanding = memory->get_max_outstanding();
+    p.b_descriptor = cfg_prefetch_descriptors;
+    p.dataflow = cfg_dataflow_cached;
+    p.tile_m = cfg_tile_rows;
+    p.tile_n = cfg_tile_cols;
+    p.tile_k = cfg_tile_k;
+    p.k_accumulate = cfg_k_accumulate;
+    return p;
+}
+
+// Estimate the whole tile loop of every GEMM of the batch in closed form
+// instead of simulating it. The clock still advances by the estimated total
+// so callers observe the same elapsed time; accumulator memory is left
+// untouched.
+bool SystolicArray::run_analytical() {
+    const PerfModelParams params = perf_model_params();
+    uint64_t tiles = 0;
+    for (size_t g = 0; g < batch.size(); ++g) {
+        PerfEstimate e = estimate_gemm(params, batch[g].M, batch[g].N, batch[g].K);
+        // the skip handler books the skipped cycles; the estimate replaces them
+        const Stats before = stats;
+        skip_clock(e.total_cycles);
+        stats = before;
+        stats.total_cycles += e.total_cycles;
+        stats.compute_cycles += e.compute_cycles;
+        stats.load_cycles += e.load_cycles;
+        stats.memory_backpressure_cycles += e.memory_backpressure_cycles;
+        stats.memory_stall_cycles += e.load_cycles + e.memory_backpressure_cycles;
+        stats.mac_operations += e.mac_operations;
+        stats.memory_accesses += e.memory_accesses;
+        current_cycle += e.total_cycles;
+        tiles += e.tiles;
+        close_gemm(static_cast<int>(g));
+    }
+    current_state = State::DONE;
+    LOG_INFO("Analytical estimate: {} cycles over {} tiles", stats.total_cycles, tiles);
+    return true;
+}
+
+bool SystolicArray::begin_run(int M, int N, int K,
+                              Addr a_addr, Addr b_addr, Addr c_addr) {
+    return begin_batch({GemmDesc{M, N, K, a_addr, b_addr, c_addr}});
+}
+
+// Validate the GEMMs, resolve packed strides and reset the array for a new
+// run over them.
+bool SystolicArray::set_batch(const std::vector<GemmDesc> &gemms) {
+    if (gemms.empty()) {
+        LOG_ERROR("run: empty batch");
         return false;
     }
+    std::vector<GemmDesc> resolved(gemms);
+    for (GemmDesc &g : resolved) {
+        if (g.K <= 0 || g.M <= 0 || g.N <= 0) {
+            LOG_ERROR("run: invalid dimensions");
+            return false;
+        }
+        if (g.lda == 0) g.lda = g.K;
+        if (g.ldb == 0) g.ldb = g.N;
+        if (g.ldc == 0) g.ldc = g.N;
+        if (g.lda < g.K || g.ldb < g.N || g.ldc < g.N) {
+            LOG_ERROR("run: leading dimension smaller than a row (lda={}, ldb={}, ldc={})", g.lda, g.ldb, g.ldc);
+            return false;
+        }
+    }
 
     // Reset array state
     reset();
+    batch = std::move(resolved);
+    gemm_stats.assign(batch.size(), Stats{});
+    gemm_mark = Stats{};
+    return true;
+}
 
-    int tiles_total = ((M + cfg_array_rows - 1) / cfg_array_rows) *
-                      ((N + cfg_array_cols - 1) / cfg_array_cols) *
-                      ((K + cfg_array_cols - 1) / cfg_array_cols);
-    int tiles_done = 0;
-
-    // Preallocate local FIFO pools
-    std::vector<FIFO> localA_pool(cfg_array_rows);
-    std::vector<FIFO> localB_pool(cfg_array_cols);
-
-    for (int mb = 0; mb < M; mb += cfg_array_rows) {
-        int m_tile = std::min(cfg_array_rows, M - mb);
-        for (int nb = 0; nb < N; nb += cfg_array_cols) {
-            int n_tile = std::min(cfg_array_cols, N - nb);
-            for (int kb = 0; kb < K; kb += cfg_array_cols) {
-                int k_tile = std::min(cfg_array_cols, K - kb);
-
-                // reset local FIFOs
-                for (int i = 0; i < m_tile; ++i) localA_pool[i].reset(k_tile + 4);
-                for (int j = 0; j < n_tile; ++j) localB_pool[j].reset(k_tile + 4);
-
-                size_t queue_depth = k_tile + 4;
-                std::vector<std::shared_ptr<std::deque<DataType>>> completionA(m_tile);
-                std::vector<std::shared_ptr<std::deque<DataType>>> completionB(n_tile);
-                // Issue prefetch requests
-                if (!issue_prefetch_for_tile(mb, nb, kb, m_tile, n_tile, k_tile,
-                                              K, N,
-                                              a_addr, b_addr,
-                                              localA_pool, localB_pool,
-                                              completionA, completionB, queue_depth)) {
-                    LOG_ERROR("run: prefetch failed for tile");
-                    return false;
-                }
+bool SystolicArray::begin_batch(const std::vector<GemmDesc> &gemms) {
+    if (!set_batch(gemms)) return false;
+    run_pos.tiles_total = 0;
+    for (const GemmDesc &g : batch) {
+        run_pos.tiles_total += ((g.M + blocks.m - 1) / blocks.m) * ((g.N + blocks.n - 1) / blocks.n) *
+                               ((g.K + blocks.k - 1) / blocks.k);
+    }
+    run_pos.tiles_done = 0;
+    enter_gemm(0);
+    run_pos.active = true;
+    return true;
+}
 
-                // Wait for prefetch to fill local FIFOs
-                if (!wait_for_prefetch(m_tile, n_tile, k_tile, localA_pool, localB_pool)) {
-                    LOG_ERROR("run: prefetch timeout for tile");
-                    return false;
-                }
+bool SystolicArray::run_batch(const std::vector<GemmDesc> &gemms) {
+    if (cfg_fidelity == Fidelity::ANALYTICAL) return set_batch(gemms) && run_analytical();
+    if (cfg_fidelity == Fidelity::FUNCTIONAL) return set_batch(gemms) && run_functional();
+    if (cfg_fidelity == Fidelity::SAMPLED) LOG_WARN("run_batch: sampled fidelity is not batched; simulating every tile");
+    if (!begin_batch(gemms)) return false;
+    return resume();
+}
 
-                // Process the tile using local FIFOs and commit accumulators into memory
-                if (!process_tile(localA_pool, localB_pool, mb, nb, m_tile, n_tile, k_tile, c_addr, N)) {
-                    LOG_ERROR("run: processing tile failed");
-                    return false;
-                }
+// Make batch[gemm] the GEMM being computed, from its first tile.
+void SystolicArray::enter_gemm(int gemm) {
+    const GemmDesc &g = batch[static_cast<size_t>(gemm)];
+    run_pos.M = g.M; run_pos.N = g.N; run_pos.K = g.K;
+    run_pos.a_addr = g.a_addr; run_pos.b_addr = g.b_addr; run_pos.c_addr = g.c_addr;
+    run_pos.lda = g.lda; run_pos.ldb = g.ldb; run_pos.ldc = g.ldc;
+    run_pos.gemm = gemm;
+    run_pos.mb = run_pos.nb = run_pos.kb = 0;
+}
+
+// GEMM `gemm` is done: book the stats since the previous boundary to it.
+void SystolicArray::close_gemm(int gemm) {
+    gemm_stats[static_cast<size_t>(gemm)] = stats_delta(stats, gemm_mark);
+    gemm_mark = stats;
+}
+
+SystolicArray::Stats SystolicArray::stats_delta(const Stats &now, const Stats &before) {
+    Stats d;
+    d.total_cycles = now.total_cycles - before.total_cycles;
+    d.compute_cycles = now.compute_cycles - before.compute_cycles;
+    d.memory_stall_cycles = now.memory_stall_cycles - before.memory_stall_cycles;
+    d.mac_operations = now.mac_operations - before.mac_operations;
+    d.memory_accesses = now.memory_accesses - before.memory_accesses;
+    d.load_cycles = now.load_cycles - before.load_cycles;
+    d.drain_cycles = now.drain_cycles - before.drain_cycles;
+    d.memory_backpressure_cycles = now.memory_backpressure_cycles - before.memory_backpressure_cycles;
+    d.tile_cache_hits = now.tile_cache_hits - before.tile_cache_hits;
+    d.tile_cache_misses = now.tile_cache_misses - before.tile_cache_misses;
+    d.tile_cache_verify_failures = now.tile_cache_verify_failures - before.tile_cache_verify_failures;
+    d.a_row_hits = now.a_row_hits - before.a_row_hits;
+    d.a_row_misses = now.a_row_misses - before.a_row_misses;
+    d.a_bank_conflict_cycles = now.a_bank_conflict_cycles - before.a_bank_conflict_cycles;
+    d.b_row_hits = now.b_row_hits - before.b_row_hits;
+    d.b_row_misses = now.b_row_misses - before.b_row_misses;
+    d.b_bank_conflict_cycles = now.b_bank_conflict_cycles - before.b_bank_conflict_cycles;
+    d.writeback_bursts = now.writeback_bursts - before.writeback_bursts;
+    d.buffer_hits = now.buffer_hits - before.buffer_hits;
+    d.buffer_misses = now.buffer_misses - before.buffer_misses;
+    d.buffer_saved_elems = now.buffer_saved_elems - before.buffer_saved_elems;
+    d.prefetch_overlap_cycles = now.prefetch_overlap_cycles - before.prefetch_overlap_cycles;
+    d.prefetch_ready_tiles = now.prefetch_ready_tiles - before.prefetch_ready_tiles;
+    d.preload_cycles = now.preload_cycles - before.preload_cycles;
+    return d;
+}
+
+// Tile loop order is cube.loop_order (mb -> nb -> kb by default); step to
+// the tile after the current one, which after the last tile of a GEMM is
+// the first tile of the next GEMM in the batch.
+void SystolicArray::advance_tile_position() {
+    if (next_tile_position(batch[static_cast<size_t>(run_pos.gemm)], run_pos.mb, run_pos.nb, run_pos.kb)) return;
+    if (run_pos.gemm + 1 < static_cast<int>(batch.size())) {
+        close_gemm(run_pos.gemm);
+        enter_gemm(run_pos.gemm + 1);
+    }
+}
+
+bool SystolicArray::next_tile_position(const GemmDesc &g, int &mb, int &nb, int &kb) const {
+    int *pos[3] = {&mb, &nb, &kb};
+    const int step[3] = {blocks.m, blocks.n, blocks.k};
+    const int end[3] = {g.M, g.N, g.K};
+    for (int level = 2; level >= 0; --level) {
+        const int d = loop_dims[static_cast<size_t>(level)];
+        *pos[d] += step[d];
+        if (*pos[d] < end[d]) return true;
+        // past the last tile the outermost position is left at its end
+        if (level > 0) *pos[d] = 0;
+    }
+    return false;
+}
+
+bool SystolicArray::starts_outer_loop(int mb, int nb, int kb) const {
+    const int pos[3] = {mb, nb, kb};
+    return pos[loop_dims[1]] == 0 && pos[loop_dims[2]] == 0;
+}
+
+// Cycle-accurate prefetch + compute + commit of the tile at (mb, nb, kb) of
+// the GEMM described by run_pos. With lookahead the tile's loads were
+// usually issued while an earlier tile computed; the next tiles' loads are
+// queued before waiting on this one's.
+bool SystolicArray::simulate_tile(int mb, int nb, int kb) {
+    // Under K accumulation the front load may be the previous K chunk of
+    // this output tile; the tile's own load follows it.
+    const size_t cur = holds_previous_chunk(kb) ? 1 : 0;
+    if (tile_loads.size() > cur && (tile_loads[cur].gemm != run_pos.gemm || tile_loads[cur].mb != mb ||
+                                    tile_loads[cur].nb != nb || tile_loads[cur].kb != kb)) {
+        discard_tile_loads();
+    }
+    if (tile_loads.size() < cur) {
+        LOG_ERROR("run: previous K chunk of the output tile is not loaded");
+        return false;
+    }
+    if (tile_loads.size() == cur && !issue_prefetch_for_tile(run_pos.gemm, mb, nb, kb, false)) {
+        LOG_ERROR("run: prefetch failed for tile");
+        return false;
+    }
+    issue_lookahead(static_cast<size_t>(cfg_prefetch_depth) + 1 + cur);
+
+    // Wait for prefetch to fill local FIFOs
+    if (!wait_for_prefetch(tile_loads[cur])) {
+        LOG_ERROR("run: prefetch timeout for tile");
+        return false;
+    }
 
-                tiles_done++;
-                if (cfg_progress_interval > 0 && (tiles_done % cfg_progress_interval) == 0) {
-                    LOG_INFO("Completed {} / {} tiles ({}%)", tiles_done, tiles_total, (100.0 * tiles_done / tiles_total));
+    const TileLoad load = tile_loads[cur];
+    if (local_buffer) {
+        if (local_buffer->policy() == BufferPolicy::EXPLICIT && starts_outer_loop(mb, nb, kb)) {
+            // the outer loop moved on: panels indexed by its dimension are not
+            // reused again (A is indexed by M and K, B by K and N)
+            if (loop_dims[0] != 1) local_buffer->release(LocalBuffer::kOperandA);
+            if (loop_dims[0] != 0) local_buffer->release(LocalBuffer::kOperandB);
+        }
+        fill_local_buffer(load);
+    }
+
+    // Process the tile using local FIFOs and commit accumulators into memory
+    const bool ok = process_tile(load, cur ? &tile_loads.front() : nullptr);
+    // a held chunk's tail has entered the array by now; this chunk is held in
+    // turn while more K chunks of the output tile follow
+    if (cur) tile_loads.pop_front();
+    const bool more_chunks = kb + load.k_tile < run_pos.K;
+    if (!(more_chunks && holds_previous_chunk(kb + load.k_tile))) tile_loads.pop_front();
+    if (!ok) {
+        LOG_ERROR("run: processing tile failed");
+        return false;
+    }
+    return true;
+}
+
+// Capture the operands fetched from memory for a tile into the local
+// buffer before the array consumes them. The FIFOs hold exactly the tile,
+// in the dataflow's layout.
+void SystolicArray::fill_local_buffer(const TileLoad &load) {
+    auto peek = [](const FIFO &f, int n) { return f.buffer[static_cast<size_t>((f.read_ptr + n) % f.depth)]; };
+    const FifoSet &fifos = fifo_sets[static_cast<size_t>(load.set)];
+    const GemmDesc &g = batch[static_cast<size_t>(load.gemm)];
+    const int m_tile = load.m_tile, n_tile = load.n_tile, k_tile = load.k_tile;
+    if (load.fill_a) {
+        std::vector<DataType> a(static_cast<size_t>(m_tile) * k_tile);
+        for (int i = 0; i < m_tile; ++i)
+            for (int kk = 0; kk < k_tile; ++kk)
+                a[static_cast<size_t>(i) * k_tile + kk] = a_by_row() ? peek(fifos.a[i], kk) : peek(fifos.a[kk], i);
+        const Addr base = g.a_addr + static_cast<Addr>(load.mb) * static_cast<Addr>(g.lda) + static_cast<Addr>(load.kb);
+        local_buffer->insert(LocalBuffer::Key{LocalBuffer::kOperandA, base, static_cast<uint32_t>(m_tile),
+                                              static_cast<uint32_t>(k_tile), static_cast<Addr>(g.lda)}, std::move(a));
+    }
+    if (load.fill_b) {
+        std::vector<DataType> b(static_cast<size_t>(k_tile) * n_tile);
+        for (int kk = 0; kk < k_tile; ++kk)
+            for (int j = 0; j < n_tile; ++j)
+                b[static_cast<size_t>(kk) * n_tile + j] = b_by_col() ? peek(fifos.b[j], kk) : peek(fifos.b[kk], j);
+        const Addr base = g.b_addr + static_cast<Addr>(load.kb) * static_cast<Addr>(g.ldb) + static_cast<Addr>(load.nb);
+        local_buffer->insert(LocalBuffer::Key{LocalBuffer::kOperandB, base, static_cast<uint32_t>(k_tile),
+                                              static_cast<uint32_t>(n_tile), static_cast<Addr>(g.ldb)}, std::move(b));
+    }
+}
+
+// Useful MACs of an (m x k) * (k x n) product as the PE grid counts them: a
+// non-zero element of the streamed operand times each stationary / top-fed
+// operand it meets. A streams past the n columns of B, except under
+// input-stationary, where B streams past the m held rows of A.
+static uint64_t useful_macs(Dataflow dataflow, const std::vector<DataType> &A, const std::vector<DataType> &B,
+                            int m, int n) {
+    auto nonzero = [](const std::vector<DataType> &v) {
+        return static_cast<uint64_t>(std::count_if(v.begin(), v.end(), [](DataType x) { return x != 0; }));
+    };
+    if (dataflow == Dataflow::INPUT_STATIONARY) return nonzero(B) * static_cast<uint64_t>(m);
+    return nonzero(A) * static_cast<uint64_t>(n);
+}
+
+// Run one tile, through the timing memo when enabled. A tile that starts and
+// ends with an idle Mem has timing that depends only on its shape, so a
+// repeat replays the recorded deltas on the clock and computes the data on
+// the host. With cube.tile_cache_verify hits are simulated and compared.
+// A banked Mem carries open rows and the local buffer its contents across
+// tiles, so neither is ever cached; nor is a tile whose loads were issued
+// ahead, nor a K chunk that accumulates into its neighbours.
+bool SystolicArray::run_tile(int mb, int nb, int kb) {
+    const bool cacheable = cfg_tile_cache && memory->idle() && wcb.empty() && tile_loads.empty() &&
+                           !memory->banked() && !local_buffer && !accumulate_k();
+    if (!cacheable) return simulate_tile(mb, nb, kb);
+
+    const int m_tile = std::min(blocks.m, run_pos.M - mb);
+    const int n_tile = std::min(blocks.n, run_pos.N - nb);
+    const int k_tile = std::min(blocks.k, run_pos.K - kb);
+    const auto key = std::make_tuple(m_tile, n_tile, k_tile);
+    auto hit = tile_cache.find(key);
+    if (hit != tile_cache.end() && !cfg_tile_cache_verify) {
+        replay_tile_timing(hit->second);
+        stats.tile_cache_hits++;
+        return compute_tile_functional(mb, nb, kb, m_tile, n_tile, k_tile);
+    }
+
+    const Stats before = stats;
+    if (!simulate_tile(mb, nb, kb)) return false;
+    if (!memory->idle() || !wcb.empty()) return true; // left requests behind: not replayable
+    const TileTiming t = timing_since(before);
+    if (hit == tile_cache.end()) {
+        tile_cache.emplace(key, t);
+        stats.tile_cache_misses++;
+    } else {
+        // A replay books the recorded timing plus this tile's own MACs.
+        std::vector<DataType> a, b;
+        if (!load_tile(mb, nb, kb, m_tile, n_tile, k_tile, a, b)) return false;
+        TileTiming replay = hit->second;
+        replay.mac_operations = useful_macs(cfg_dataflow_cached, a, b, m_tile, n_tile);
+        stats.tile_cache_hits++;
+        if (!(replay == t)) {
+            stats.tile_cache_verify_failures++;
+            LOG_WARN("tile cache: replay of {}x{}x{} tile at ({}, {}, {}) would be {} cycles / {} MACs, simulated {} / {}",
+                     m_tile, n_tile, k_tile, mb, nb, kb, replay.cycles, replay.mac_operations, t.cycles, t.mac_operations);
+        }
+    }
+    return true;
+}
+
+SystolicArray::TileTiming SystolicArray::timing_since(const Stats &before) const {
+    TileTiming t;
+    t.cycles = stats.total_cycles - before.total_cycles;
+    t.compute_cycles = stats.compute_cycles - before.compute_cycles;
+    t.memory_stall_cycles = stats.memory_stall_cycles - before.memory_stall_cycles;
+    t.memory_accesses = stats.memory_accesses - before.memory_accesses;
+    t.load_cycles = stats.load_cycles - before.load_cycles;
+    t.drain_cycles = stats.drain_cycles - before.drain_cycles;
+    t.memory_backpressure_cycles = stats.memory_backpressure_cycles - before.memory_backpressure_cycles;
+    t.mac_operations = stats.mac_operations - before.mac_operations;
+    return t;
+}
+
+void SystolicArray::replay_tile_timing(const TileTiming &t) {
+    // The skip handler books total_cycles / current_cycle (and no stall: the
+    // memory is idle); the remaining counters come from the recording, except
+    // mac_operations, which compute_tile_functional counts from the data.
+    skip_clock(t.cycles);
+    stats.compute_cycles += t.compute_cycles;
+    stats.memory_stall_cycles += t.memory_stall_cycles;
+    stats.memory_accesses += t.memory_accesses;
+    stats.load_cycles += t.load_cycles;
+    stats.drain_cycles += t.drain_cycles;
+    stats.memory_backpressure_cycles += t.memory_backpressure_cycles;
+}
+
+// A and B blocks of one tile of the current GEMM, read from memory untimed.
+bool SystolicArray::load_tile(int mb, int nb, int kb, int m_tile, int n_tile, int k_tile,
+                              std::vector<DataType> &a, std::vector<DataType> &b) const {
+    a.resize(static_cast<size_t>(m_tile) * k_tile);
+    b.resize(static_cast<size_t>(k_tile) * n_tile);
+    const Addr a_tile = static_cast<Addr>(mb) * static_cast<Addr>(run_pos.lda) + static_cast<Addr>(kb) + run_pos.a_addr;
+    const Addr b_tile = static_cast<Addr>(kb) * static_cast<Addr>(run_pos.ldb) + static_cast<Addr>(nb) + run_pos.b_addr;
+    return load_rows(a_tile, m_tile, k_tile, run_pos.lda, a.data()) &&
+           load_rows(b_tile, k_tile, n_tile, run_pos.ldb, b.data());
+}
+
+bool SystolicArray::compute_tile_functional(int mb, int nb, int kb, int m_tile, int n_tile, int k_tile) {
+    std::vector<DataType> a, b;
+    if (!load_tile(mb, nb, kb, m_tile, n_tile, k_tile, a, b)) return false;
+    std::vector<AccType> c(static_cast<size_t>(m_tile) * n_tile);
+    util::gemm_i16_i32(m_tile, n_tile, k_tile, a.data(), k_tile, b.data(), n_tile, c.data(), n_tile);
+    for (int i = 0; i < m_tile; ++i) {
+        for (int j = 0; j < n_tile; ++j) {
+            Addr idx = static_cast<Addr>(mb + i) * static_cast<Addr>(run_pos.ldc) + static_cast<Addr>(nb + j);
+            memory->store_acc_direct(run_pos.c_addr + idx, c[static_cast<size_t>(i) * n_tile + j]);
+        }
+    }
+    stats.mac_operations += useful_macs(cfg_dataflow_cached, a, b, m_tile, n_tile);
+    return true;
+}
+
+bool SystolicArray::resume(int max_tiles) {
+    if (!run_pos.active) {
+        LOG_ERROR("resume: no run in progress");
+        return false;
+    }
+    int processed = 0;
+    while (run_pos.tiles_done < run_pos.tiles_total) {
+        // Returning here leaves the array at a tile boundary, which is where
+        // checkpoints are taken.
+        if (max_tiles >= 0 && processed >= max_tiles) return true;
+        if (!run_tile(run_pos.mb, run_pos.nb, run_pos.kb)) return false;
+
+        run_pos.tiles_done++;
+        processed++;
+        advance_tile_position();
+        if (cfg_progress_interval > 0 && (run_pos.tiles_done % cfg_progress_interval) == 0) {
+            LOG_INFO("Completed {} / {} tiles ({}%)", run_pos.tiles_done, run_pos.tiles_total,
+                     (100.0 * run_pos.tiles_done / run_pos.tiles_total));
+        }
+    }
+    // results of the last tiles may still be draining
+    if (cfg_timed_writeback) flush_writeback();
+    close_gemm(run_pos.gemm);
+
+    run_pos.active = false;
+    current_state = State::DONE;
+    LOG_INFO("Matrix multiplication completed in {} cycles", current_cycle);
+    return true;
+}
+
+// Compute C = A * B of every GEMM of the batch on the host and commit it
+// exactly like cycle mode does (store_acc_direct adds into accumulator
+// memory). No cycles elapse; only mac_operations is filled.
+bool SystolicArray::run_functional() {
+    for (size_t g = 0; g < batch.size(); ++g) {
+        const GemmDesc &d = batch[g];
+        std::vector<DataType> A(static_cast<size_t>(d.M) * d.K);
+        std::vector<DataType> B(static_cast<size_t>(d.K) * d.N);
+        if (!load_rows(d.a_addr, d.M, d.K, d.lda, A.data()) || !load_rows(d.b_addr, d.K, d.N, d.ldb, B.data())) {
+            LOG_ERROR("run: A/B outside memory (a_addr={}, b_addr={})", d.a_addr, d.b_addr);
+            return false;
+        }
+        std::vector<AccType> C(static_cast<size_t>(d.M) * d.N);
+        util::gemm_i16_i32(d.M, d.N, d.K, A.data(), d.K, B.data(), d.N, C.data(), d.N, workers.get());
+        for (int i = 0; i < d.M; ++i) {
+            const Addr row = d.c_addr + static_cast<Addr>(i) * static_cast<Addr>(d.ldc);
+            for (int j = 0; j < d.N; ++j) {
+                memory->store_acc_direct(row + static_cast<Addr>(j), C[static_cast<size_t>(i) * d.N + j]);
+            }
+        }
+
+        stats.mac_operations += useful_macs(cfg_dataflow_cached, A, B, d.M, d.N);
+        close_gemm(static_cast<int>(g));
+    }
+    current_state = State::DONE;
+    return true;
+}
+
+bool SystolicArray::load_rows(Addr addr, int rows, int cols, int ld, DataType *dst) const {
+    if (ld == cols) return memory->load_direct(addr, static_cast<size_t>(rows) * cols, dst);
+    for (int r = 0; r < rows; ++r) {
+        if (!memory->load_direct(addr + static_cast<Addr>(r) * static_cast<Addr>(ld), static_cast<size_t>(cols),
+                                 dst + static_cast<size_t>(r) * cols)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Sampled run: only a subset of tiles is simulated cycle-accurately; every
+// other tile contributes its data functionally and its timing is
+// extrapolated from the sampled tiles of the same shape.
+//   * warm-up: the first cfg_sample_warmup tiles in loop order;
+//   * edge: the first tile of every distinct (m_tile, n_tile, k_tile) shape;
+//   * interior: cfg_sample_tiles tiles drawn uniformly from the rest.
+// The data path computes the whole GEMM with the host kernel and removes the
+// sampled tiles' partial sums (mod 2^32) before those tiles commit their own,
+// so accumulator memory ends bit-identical to a full cycle run.
+bool SystolicArray::run_sampled(int M, int N, int K,
+                                Addr a_addr, Addr b_addr, Addr c_addr) {
+    if (!begin_run(M, N, K, a_addr, b_addr, c_addr)) return false;
+
+    const int tiles_m = (M + blocks.m - 1) / blocks.m;
+    const int tiles_n = (N + blocks.n - 1) / blocks.n;
+    const int tiles_k = (K + blocks.k - 1) / blocks.k;
+    const int64_t total = static_cast<int64_t>(tiles_m) * tiles_n * tiles_k;
+    struct TileRef { int64_t index; int mb, nb, kb, shape; };
+    // Tile index follows the loop order of resume() (innermost fastest).
+    const int64_t tiles_of[3] = {tiles_m, tiles_n, tiles_k};
+    auto index_of = [&](const int64_t (&idx)[3]) {
+        int64_t t = 0;
+        for (int level = 0; level < 3; ++level) {
+            const int d = loop_dims[static_cast<size_t>(level)];
+            t = t * tiles_of[d] + idx[d];
+        }
+        return t;
+    };
+    auto tile_at = [&](int64_t t) {
+        TileRef r;
+        r.index = t;
+        int64_t idx[3];
+        for (int level = 2; level >= 0; --level) {
+            const int d = loop_dims[static_cast<size_t>(level)];
+            idx[d] = t % tiles_of[d];
+            t /= tiles_of[d];
+        }
+        r.mb = static_cast<int>(idx[0]) * blocks.m;
+        r.nb = static_cast<int>(idx[1]) * blocks.n;
+        r.kb = static_cast<int>(idx[2]) * blocks.k;
+        // shape class: bit set for each dimension that is a partial (edge) tile
+        r.shape = (r.mb + blocks.m > M ? 1 : 0) | (r.nb + blocks.n > N ? 2 : 0) | (r.kb + blocks.k > K ? 4 : 0);
+        return r;
+    };
+
+    // Per-shape population (edge tiles sit at the end of each loop level, so
+    // the first tile of a shape has every edge index at its last position).
+    int64_t population[8] = {0};
+    for (int s = 0; s < 8; ++s) {
+        int64_t cm = (s & 1) ? (M % blocks.m ? 1 : 0) : M / blocks.m;
+        int64_t cn = (s & 2) ? (N % blocks.n ? 1 : 0) : N / blocks.n;
+        int64_t ck = (s & 4) ? (K % blocks.k ? 1 : 0) : K / blocks.k;
+        population[s] = cm * cn * ck;
+    }
+    std::map<int64_t, bool> sampled; // tile index -> is warm-up
+    for (int64_t t = 0; t < std::min<int64_t>(cfg_sample_warmup, total); ++t) sampled[t] = true;
+    for (int s = 0; s < 8; ++s) {
+        if (population[s] == 0) continue;
+        const int64_t idx[3] = {(s & 1) ? tiles_m - 1 : 0, (s & 2) ? tiles_n - 1 : 0, (s & 4) ? tiles_k - 1 : 0};
+        sampled.emplace(index_of(idx), false);
+    }
+    std::mt19937_64 rng(static_cast<uint64_t>(cfg_sample_seed));
+    const int64_t want = std::min<int64_t>(total, static_cast<int64_t>(sampled.size()) + cfg_sample_tiles);
+    std::uniform_int_distribution<int64_t> pick(0, total - 1);
+    while (static_cast<int64_t>(sampled.size()) < want) sampled.emplace(pick(rng), false);
+
+    // Functional data for every tile, minus the sampled tiles' contributions.
+    if (static_cast<int64_t>(sampled.size()) < total) {
+        std::vector<DataType> A(static_cast<size_t>(M) * K);
+        std::vector<DataType> B(static_cast<size_t>(K) * N);
+        if (!memory->load_direct(a_addr, A.size(), A.data()) ||
+            !memory->load_direct(b_addr, B.size(), B.data())) {
+            LOG_ERROR("run: A/B outside memory (a_addr={}, b_addr={})", a_addr, b_addr);
+            return false;
+        }
+        std::vector<AccType> C(static_cast<size_t>(M) * N);
+        util::gemm_i16_i32(M, N, K, A.data(), K, B.data(), N, C.data(), N, workers.get());
+        std::vector<AccType> part(static_cast<size_t>(blocks.m) * blocks.n);
+        for (const auto &kv : sampled) {
+            TileRef r = tile_at(kv.first);
+            int m_tile = std::min(blocks.m, M - r.mb);
+            int n_tile = std::min(blocks.n, N - r.nb);
+            int k_tile = std::min(blocks.k, K - r.kb);
+            util::gemm_i16_i32(m_tile, n_tile, k_tile,
+                               A.data() + static_cast<size_t>(r.mb) * K + r.kb, K,
+                               B.data() + static_cast<size_t>(r.kb) * N + r.nb, N,
+                               part.data(), n_tile);
+            for (int i = 0; i < m_tile; ++i) {
+                for (int j = 0; j < n_tile; ++j) {
+                    auto &c = C[static_cast<size_t>(r.mb + i) * N + r.nb + j];
+                    c = static_cast<AccType>(static_cast<uint32_t>(c) -
+                                             static_cast<uint32_t>(part[static_cast<size_t>(i) * n_tile + j]));
                 }
             }
         }
+        for (size_t idx = 0; idx < C.size(); ++idx) {
+            memory->store_acc_direct(c_addr + static_cast<Addr>(idx), C[idx]);
+        }
+    }
+
+    // Cycle-accurate sampled tiles; record per-tile stat deltas by shape.
+    struct Sample { Stats delta; bool warmup; };
+    std::vector<Sample> by_shape[8];
+    for (const auto &kv : sampled) {
+        TileRef r = tile_at(kv.first);
+        Stats before = stats;
+        if (!run_tile(r.mb, r.nb, r.kb)) return false;
+        Stats d = stats;
+        d.total_cycles -= before.total_cycles;
+        d.compute_cycles -= before.compute_cycles;
+        d.memory_stall_cycles -= before.memory_stall_cycles;
+        d.mac_operations -= before.mac_operations;
+        d.memory_accesses -= before.memory_accesses;
+        d.load_cycles -= before.load_cycles;
+        d.drain_cycles -= before.drain_cycles;
+        d.memory_backpressure_cycles -= before.memory_backpressure_cycles;
+        by_shape[r.shape].push_back(Sample{d, kv.second});
+    }
+    // The last sampled tile's results may still sit in the write-combining
+    // buffer; drain them on the clock so the tail is measured too.
+    flush_writeback();
+
+    // Extrapolate unsampled tiles per shape from the non-warm-up samples
+    // (warm-up samples only if nothing else covers the shape). The 95%
+    // interval uses the sample variance with a finite-population correction.
+    sample_report = SampleReport{};
+    sample_report.tiles_total = static_cast<uint64_t>(total);
+    sample_report.tiles_sampled = sampled.size();
+    double extra[8] = {0}; // total, compute, stall, mac, accesses, load, drain, backpressure
+    double variance = 0.0;
+    for (int s = 0; s < 8; ++s) {
+        int64_t unsampled = population[s] - static_cast<int64_t>(by_shape[s].size());
+        if (unsampled <= 0) continue;
+        std::vector<const Stats*> use;
+        for (const auto &smp : by_shape[s]) if (!smp.warmup) use.push_back(&smp.delta);
+        if (use.empty()) for (const auto &smp : by_shape[s]) use.push_back(&smp.delta);
+        const double n = static_cast<double>(use.size());
+        double mean[8] = {0};
+        for (const Stats *d : use) {
+            const uint64_t v[8] = {d->total_cycles, d->compute_cycles, d->memory_stall_cycles, d->mac_operations,
+                                   d->memory_accesses, d->load_cycles, d->drain_cycles, d->memory_backpressure_cycles};
+            for (int f = 0; f < 8; ++f) mean[f] += static_cast<double>(v[f]) / n;
+        }
+        for (int f = 0; f < 8; ++f) extra[f] += mean[f] * static_cast<double>(unsampled);
+        if (use.size() > 1) {
+            double ss = 0.0;
+            for (const Stats *d : use) {
+                double e = static_cast<double>(d->total_cycles) - mean[0];
+                ss += e * e;
+            }
+            const double pop = static_cast<double>(population[s]);
+            const double fpc = std::max(0.0, 1.0 - n / pop);
+            variance += static_cast<double>(unsampled) * static_cast<double>(unsampled) * (ss / (n - 1.0)) / n * fpc;
+        }
     }
 
+    // Account the extrapolated cycles on the clock so callers see the same
+    // elapsed time, then install the extrapolated totals.
+    const Stats measured = stats;
+    const Cycle skipped = static_cast<Cycle>(std::llround(extra[0]));
+    skip_clock(skipped);
+    stats = measured;
+    stats.total_cycles += skipped;
+    stats.compute_cycles += static_cast<uint64_t>(std::llround(extra[1]));
+    stats.memory_stall_cycles += static_cast<uint64_t>(std::llround(extra[2]));
+    stats.mac_operations += static_cast<uint64_t>(std::llround(extra[3]));
+    stats.memory_accesses += static_cast<uint64_t>(std::llround(extra[4]));
+    stats.load_cycles += static_cast<uint64_t>(std::llround(extra[5]));
+    stats.drain_cycles += static_cast<uint64_t>(std::llround(extra[6]));
+    stats.memory_backpressure_cycles += static_cast<uint64_t>(std::llround(extra[7]));
+    current_cycle = measured.total_cycles + skipped;
+
+    const double half = 1.96 * std::sqrt(variance);
+    sample_report.total_cycles = static_cast<double>(stats.total_cycles);
+    sample_report.ci95_low = sample_report.total_cycles - half;
+    sample_report.ci95_high = sample_report.total_cycles + half;
+
+    close_gemm(0);
+    run_pos.active = false;
     current_state = State::DONE;
-    LOG_INFO("Matrix multiplication completed in {} cycles", current_cycle);
+    LOG_INFO("Sampled {} / {} tiles: ~{} cycles (95% CI [{:.0f}, {:.0f}])", sample_report.tiles_sampled,
+             sample_report.tiles_total, stats.total_cycles, sample_report.ci95_low, sample_report.ci95_high);
     return true;
 }
 
+static void save_fifo(util::SnapshotWriter &w, const FIFO &f) {
+    w.put_vec(f.buffer);
+    w.put(f.depth);
+    w.put(f.read_ptr);
+    w.put(f.write_ptr);
+    w.put(f.count);
+}
+
+static bool load_fifo(util::SnapshotReader &r, FIFO &f) {
+    return r.get_vec(f.buffer) && r.get(f.depth) && r.get(f.read_ptr) &&
+           r.get(f.write_ptr) && r.get(f.count);
+}
 
+bool SystolicArray::save_checkpoint(const std::string &path) const {
+    util::SnapshotWriter w(path);
+    if (!w.good()) {
+        LOG_ERROR("save_checkpoint: cannot open {}", path);
+        return false;
+    }
+    w.tag("XSIM");
+    w.put(kCheckpointVersion);
+    w.put(cfg_array_rows);
+    w.put(cfg_array_cols);
+    w.put(cfg_dataflow_cached);
+    w.put(cfg_loop_order);
+    w.put(blocks);
+    w.put(cfg_k_accumulate);
+    clock->save(w);
+    memory->save(w);
+    grid.save(w);
 
-// PE methods implemented in pe.cpp
+    w.tag("SA  ");
+    w.put(current_state);
+    w.put(current_cycle);
+    w.put(stats);
+    w.put(run_pos);
+    w.put_vec(batch);
+    w.put_vec(gemm_stats);
+    w.put(gemm_mark);
+    w.put<uint64_t>(fifo_sets.size());
+    for (const auto &set : fifo_sets) {
+        for (const auto &f : set.a) save_fifo(w, f);
+        for (const auto &f : set.b) save_fifo(w, f);
+    }
+    w.put_vec(std::vector<TileLoad>(tile_loads.begin(), tile_loads.end()));
+    w.put<uint64_t>(wcb.size());
+    for (const auto &b : wcb) {
+        w.put(b.addr);
+        w.put_vec(b.vals);
+    }
+    w.put(writes_in_flight);
+    dma->save(w);
+    w.put<uint8_t>(local_buffer ? 1 : 0);
+    if (local_buffer) local_buffer->save(w);
+    return w.good();
+}
+
+bool SystolicArray::load_checkpoint(const std::string &path) {
+    util::SnapshotReader r(path);
+    if (!r.good()) {
+        LOG_ERROR("load_checkpoint: cannot map {}", path);
+        return false;
+    }
+    uint32_t version = 0;
+    int rows = 0, cols = 0;
+    Dataflow dataflow = Dataflow::OUTPUT_STATIONARY;
+    LoopOrder order = LoopOrder::MNK;
+    TileBlocks tiles{};
+    bool k_accumulate = false;
+    if (!r.expect_tag("XSIM") || !r.get(version) || version != kCheckpointVersion ||
+        !r.get(rows) || !r.get(cols) || rows != cfg_array_rows || cols != cfg_array_cols ||
+        !r.get(dataflow) || dataflow != cfg_dataflow_cached || !r.get(order) || order != cfg_loop_order ||
+        !r.get(tiles) || tiles.m != blocks.m || tiles.n != blocks.n || tiles.k != blocks.k ||
+        !r.get(k_accumulate) || k_accumulate != cfg_k_accumulate) {
+        LOG_ERROR("load_checkpoint: {} does not match this array configuration", path);
+        return false;
+    }
+    bool ok = clock->load(r) && memory->load(r) && grid.load(r) &&
+              r.expect_tag("SA  ") && r.get(current_state) && r.get(current_cycle) &&
+              r.get(stats) && r.get(run_pos) && r.get_vec(batch) && r.get_vec(gemm_stats) && r.get(gemm_mark);
+    uint64_t sets = 0;
+    ok = ok && r.get(sets) && sets == fifo_sets.size();
+    for (auto &set : fifo_sets) {
+        for (auto &f : set.a) ok = ok && load_fifo(r, f);
+        for (auto &f : set.b) ok = ok && load_fifo(r, f);
+    }
+    std::vector<TileLoad> loads;
+    ok = ok && r.get_vec(loads);
+    tile_loads.assign(loads.begin(), loads.end());
+    uint64_t bursts = 0;
+    ok = ok && r.get(bursts);
+    wcb.clear();
+    for (uint64_t i = 0; ok && i < bursts; ++i) {
+        WriteBurst b;
+        ok = r.get(b.addr) && r.get_vec(b.vals);
+        if (ok) wcb.push_back(std::move(b));
+    }
+    ok = ok && r.get(writes_in_flight);
+    ok = ok && dma->load(r);
+    uint8_t has_buffer = 0;
+    ok = ok && r.get(has_buffer) && (has_buffer != 0) == (local_buffer != nullptr);
+    if (ok && local_buffer) ok = local_buffer->load(r);
+    if (!ok) LOG_ERROR("load_checkpoint: truncated or corrupt snapshot {}", path);
+    return ok;
+}
 
 // 修正 cycle 函数中的计算部分
 void SystolicArray::cycle() {
@@ -272,7 +1225,7 @@ void SystolicArray::cycle() {
                     DataType weight;
                     if (weight_fifo->pop(weight)) {
                         for (int i = 0; i < cfg_array_rows; i++) {
-                            pes[i][j].load_weight(weight);
+                            grid.load_weight(i, j, weight);
                         }
                     } else {
                         break;
@@ -291,7 +1244,7 @@ void SystolicArray::cycle() {
             std::vector<std::vector<AccType>> next_psum(cfg_array_rows, std::vector<AccType>(cfg_array_cols, 0));
             std::vector<DataType> outputs_collected;
 
-            // PROCESSING: now driven by per-PE ticks; here we only handle control-level actions
+            // PROCESSING: now driven by the PE grid's tick; here we only handle control-level actions
             // (weights are loaded in LOADING_WEIGHTS state). In tile-driven runs, process_tile
             // will prepare PE inputs and call clock->tick() so PEs execute.
             break;
@@ -314,8 +1267,6 @@ void SystolicArray::cycle() {
     current_cycle++;
 }
 
-// PE print_state implemented in pe.cpp
-
 // SystolicArray implementation
 SystolicArray::SystolicArray(p_clock_t external_clock, p_mem_t external_mem)
         : weight_fifo(new FIFO(16)),
@@ -328,82 +1279,134 @@ SystolicArray::SystolicArray(p_clock_t external_clock, p_mem_t external_mem)
     load_config_cache();
     
     // 初始化PE阵列 (read sizes on-demand from config file)
-    pes.resize(cfg_array_rows);
-    for (int i = 0; i < cfg_array_rows; i++) {
-        pes[i].resize(cfg_array_cols);
-        for (int j = 0; j < cfg_array_cols; j++) {
-            pes[i][j] = PE(i, j);
-        }
+    grid = PEGrid(cfg_array_rows, cfg_array_cols);
+    grid.set_dataflow(cfg_dataflow_cached);
+    if (cfg_threads > 1) {
+        // one barrier per grid phase; the controller thread takes part in each
+        workers = std::make_shared<util::WorkerPool>(cfg_threads);
+        grid.set_workers(workers, cfg_parallel_min_pes);
     }
-    // prepare pe_listener_ids structure
-    pe_listener_ids.resize(cfg_array_rows);
-    for (int i = 0; i < cfg_array_rows; ++i) pe_listener_ids[i].resize(cfg_array_cols, 0);
     
     // 初始化内存接口（使用 unique_ptr）
     if (!external_mem) {
         throw std::invalid_argument("SystolicArray requires external memory; provide via SimTop::build_mem");
     }
     memory = external_mem;
+    blocks = tile_blocks(perf_model_params());
     // 初始化/绑定时钟并将内存周期行为注册为监听器
     if (!external_clock) {
         throw std::invalid_argument("SystolicArray requires an external clock; provide via SimTop::build_clk and pass it through");
     }
     clock = external_clock;
-    // register memory cycle at highest priority (0)
-    mem_listener_id = clock->add_listener([this]() {
-        if (memory) memory->cycle();
-    }, 0);
-    // register PEs at priority 1 (they will run after memory but before controller)
-    for (int i = 0; i < cfg_array_rows; ++i) {
-        for (int j = 0; j < cfg_array_cols; ++j) {
-            // capture pointer to PE
-            PE* pe = &pes[i][j];
-            pe_listener_ids[i][j] = clock->add_listener([pe]() { pe->tick(); }, 1);
-        }
-    }
-    // register a commit listener at priority 2 to apply staged PE state (two-phase commit)
-    commit_listener_id = clock->add_listener([this]() {
-        for (int ii = 0; ii < cfg_array_rows; ++ii) {
-            for (int jj = 0; jj < cfg_array_cols; ++jj) {
-                pes[ii][jj].commit();
-            }
+    dma.reset(new DmaEngine(memory, std::max(1, get<int>("dma.channels").value_or(2)),
+                            std::max(1, get<int>("dma.queue_depth").value_or(8))));
+    // Result writes report back here, so flush_writeback() waits for this
+    // array's writes only. Registered right after the DMA engine's sink: a
+    // checkpoint stores pending requests by sink index.
+    write_sink = memory->register_sink([this](uint32_t, size_t elems) { writes_in_flight -= elems; });
+    dma->set_completion_handler([this](const DmaEngine::Completion &c) {
+        for (auto &load : tile_loads) {
+            if (c.id != load.a_id && c.id != load.b_id) continue;
+            load.pending--;
+            const bool is_a = c.id == load.a_id;
+            (is_a ? stats.a_row_hits : stats.b_row_hits) += c.bank.row_hits;
+            (is_a ? stats.a_row_misses : stats.b_row_misses) += c.bank.row_misses;
+            (is_a ? stats.a_bank_conflict_cycles : stats.b_bank_conflict_cycles) += c.bank.conflict_cycles;
+            return;
         }
-    }, 2);
-    // register SystolicArray::cycle to be driven by clock at lower priority (3)
-    sa_listener_id = clock->add_listener([this]() {
-        this->cycle();
-    }, 3);
+    });
+    // Mount the fixed Mem → PE → commit → controller → write-back → DMA pipeline as one listener:
+    // the stage order is resolved at compile time, so per-cycle dispatch is a
+    // single indirect call. Ad-hoc listeners at priority >= 1 run after it.
+    pipeline = Pipeline(MemStage{memory.get()}, PeStage{&grid}, CommitStage{&grid},
+                        ControllerStage{this}, WritebackStage{this}, DmaStage{dma.get()});
+    pipeline_listener_id = clock->add_listener([this]() {
+        pipeline.tick();
+    }, 0, [this]() -> Cycle {
+        // In event-driven mode the memory decides when the next real tick is needed.
+        Cycle dt = pipeline.cycles_until_event();
+        return dt == UINT64_MAX ? Clock::NEVER : clock->now() + dt;
+    }, [this](Cycle n) {
+        pipeline.skip(n);
+    });
     
     // 重置统计
-    stats = {0, 0, 0, 0, 0, 0, 0, 0};
+    stats = Stats{};
+    sample_report = SampleReport{};
 
-    // 预分配 completion 队列池
-    completionA_pool.resize(cfg_array_rows);
-    completionB_pool.resize(cfg_array_cols);
-    for (auto &q : completionA_pool) q = std::make_shared<std::deque<DataType>>();
-    for (auto &q : completionB_pool) q = std::make_shared<std::deque<DataType>>();
+    // 片上本地缓冲：容量按 KiB 配置，默认每个读端口一拍送一行阵列宽度的元素
+    if (get<bool>("buffer.enabled").value_or(false)) {
+        const int64_t kb = get<int64_t>("buffer.capacity_kb").value_or(256);
+        local_buffer.reset(new LocalBuffer(static_cast<size_t>(std::max<int64_t>(kb, 1)) * 1024 / sizeof(DataType),
+                                           get<int>("buffer.ports").value_or(2),
+                                           get<int>("buffer.port_width").value_or(cfg_array_cols),
+                                           get<int>("buffer.latency").value_or(2),
+                                           get<BufferPolicy>("buffer.policy").value_or(BufferPolicy::LRU)));
+    }
+
+    // 本地 FIFO 组（每行 A / 每列 B 一个），当前组 + prefetch_depth 个影子组
+    // （输出驻留下 K 累加另留一组给上一个 K 块）
+    const bool hold_chunk = cfg_k_accumulate && cfg_dataflow_cached == Dataflow::OUTPUT_STATIONARY;
+    fifo_sets.resize(static_cast<size_t>(cfg_prefetch_depth) + (hold_chunk ? 2 : 1));
+    run_pos = RunPosition{};
+
+    // 每个本地 FIFO 注册为一个完成流，内存读完成时直接写入；
+    // 各数据流按行或按列分配 FIFO，故每组按阵列较长边分配
+    const size_t edge = static_cast<size_t>(std::max(cfg_array_rows, cfg_array_cols));
+    for (auto &set : fifo_sets) {
+        set.a.resize(edge);
+        set.b.resize(edge);
+        set.stream_a = memory->register_stream(&set.a[0]);
+        for (size_t i = 1; i < edge; ++i) memory->register_stream(&set.a[i]);
+        set.stream_b = memory->register_stream(&set.b[0]);
+        for (size_t j = 1; j < edge; ++j) memory->register_stream(&set.b[j]);
+    }
 }
 
-SystolicArray::~SystolicArray() {
-    if (clock) {
-        if (mem_listener_id) clock->remove_listener(mem_listener_id);
-        if (commit_listener_id) clock->remove_listener(commit_listener_id);
-        if (sa_listener_id) clock->remove_listener(sa_listener_id);
+void SystolicArray::detach_pipeline(std::function<Cycle(Cycle limit)> hook) {
+    if (pipeline_listener_id) clock->remove_listener(pipeline_listener_id);
+    pipeline_listener_id = 0;
+    pipeline.stage<0>().mem = nullptr;
+    advance_hook = std::move(hook);
+    // A tile's timing now also depends on the other arrays' traffic.
+    if (cfg_tile_cache) {
+        LOG_WARN("detach_pipeline: tile timings are not reproducible on a shared Mem; cube.tile_cache disabled");
+        cfg_tile_cache = false;
+        tile_cache.clear();
     }
 }
 
-void SystolicArray::reset() {
-    for (int i = 0; i < cfg_array_rows; i++) {
-        for (int j = 0; j < cfg_array_cols; j++) {
-            pes[i][j].reset();
+void SystolicArray::skip_clock(Cycle n) {
+    if (!clock) return;
+    if (!advance_hook) {
+        clock->skip(n);
+        return;
+    }
+    while (n > 0) n -= advance(n);
+}
+
+SystolicArray::~SystolicArray() {
+    if (clock && pipeline_listener_id) clock->remove_listener(pipeline_listener_id);
+    if (memory) {
+        memory->unregister_sink(write_sink);
+        for (const auto &set : fifo_sets) {
+            for (size_t i = 0; i < set.a.size(); ++i) memory->unregister_stream(set.stream_a + static_cast<int>(i));
+            for (size_t j = 0; j < set.b.size(); ++j) memory->unregister_stream(set.stream_b + static_cast<int>(j));
         }
     }
+}
+
+void SystolicArray::reset() {
+    grid.reset();
     
     current_state = State::IDLE;
     current_cycle = 0;
     weight_load_ptr = activation_load_ptr = result_unload_ptr = 0;
     rows_processed = cols_processed = 0;
-    stats = {0, 0, 0, 0, 0, 0, 0, 0};
+    stats = Stats{};
+    tile_loads.clear();
+    // a new run may read different data at the same addresses
+    if (local_buffer) local_buffer->clear();
     
     // 清空FIFO
     while (!weight_fifo->empty()) {
@@ -428,10 +1431,59 @@ void SystolicArray::print_stats() const {
     LOG_INFO("Compute cycles: {}", stats.compute_cycles);
     LOG_INFO("Load cycles (prefetch wait): {}", stats.load_cycles);
     LOG_INFO("Drain cycles: {}", stats.drain_cycles);
+    if (cfg_dataflow_cached != Dataflow::OUTPUT_STATIONARY) LOG_INFO("Preload cycles: {}", stats.preload_cycles);
+    if (cfg_timed_writeback) LOG_INFO("Write-back bursts: {}", stats.writeback_bursts);
     LOG_INFO("Memory stall cycles: {} ({:.1}% )", stats.memory_stall_cycles,
              (double)stats.memory_stall_cycles / stats.total_cycles * 100);
     LOG_INFO("Memory backpressure cycles: {}", stats.memory_backpressure_cycles);
     LOG_INFO("MAC operations: {}", stats.mac_operations);
+    for (int c = 0; c < dma->channels(); ++c) {
+        const DmaEngine::ChannelStats &cs = dma->channel_stats(c);
+        LOG_INFO("DMA channel {}: {} transfers, {} requests, {} elements", c, cs.transfers, cs.requests, cs.elements);
+    }
+    if (cfg_tile_cache) {
+        uint64_t lookups = stats.tile_cache_hits + stats.tile_cache_misses;
+        LOG_INFO("Tile cache: {} hits / {} misses ({:.1f}% hit rate), {} verify failures",
+                 stats.tile_cache_hits, stats.tile_cache_misses,
+                 lookups ? 100.0 * stats.tile_cache_hits / lookups : 0.0, stats.tile_cache_verify_failures);
+    }
+    if (local_buffer) {
+        const uint64_t lookups = stats.buffer_hits + stats.buffer_misses;
+        const uint64_t fetched = stats.memory_accesses + stats.buffer_saved_elems;
+        LOG_INFO("Local buffer: {} hits / {} misses ({:.1f}% hit rate), {} evictions",
+                 stats.buffer_hits, stats.buffer_misses,
+                 lookups ? 100.0 * stats.buffer_hits / lookups : 0.0, local_buffer->evictions());
+        LOG_INFO("Local buffer saved {} memory accesses ({:.1f}% fewer)", stats.buffer_saved_elems,
+                 fetched ? 100.0 * stats.buffer_saved_elems / fetched : 0.0);
+    }
+    if (memory && memory->banked()) {
+        LOG_INFO("Bank row hits/misses: A {}/{}, B {}/{}", stats.a_row_hits, stats.a_row_misses,
+                 stats.b_row_hits, stats.b_row_misses);
+        LOG_INFO("Bank conflict cycles: A {}, B {}", stats.a_bank_conflict_cycles, stats.b_bank_conflict_cycles);
+    }
+    if (cfg_loop_order != LoopOrder::MNK || cfg_tile_rows || cfg_tile_cols || cfg_tile_k || cfg_k_accumulate) {
+        const char dims[] = "MNK";
+        LOG_INFO("Tiles: {}x{}x{} (M x N x K), loop order {}{}{}{}", blocks.m, blocks.n, blocks.k,
+                 dims[loop_dims[0]], dims[loop_dims[1]], dims[loop_dims[2]],
+                 cfg_k_accumulate ? ", accumulating across K" : "");
+    }
+    if (cfg_prefetch_depth > 0) {
+        LOG_INFO("Prefetch lookahead {}: {} compute cycles overlapped loads ({:.1f}%), {} / {} tiles ready on arrival",
+                 cfg_prefetch_depth, stats.prefetch_overlap_cycles,
+                 stats.compute_cycles ? 100.0 * stats.prefetch_overlap_cycles / stats.compute_cycles : 0.0,
+                 stats.prefetch_ready_tiles, run_pos.tiles_total);
+    }
+    if (memory && memory->coalescing()) {
+        const Mem::CoalesceStats &cs = memory->get_coalesce_stats();
+        LOG_INFO("Coalesced reads: {} merged into {} bursts, peak {} pending", cs.merged_reads, cs.bursts,
+                 cs.peak_pending);
+    }
+    if (gemm_stats.size() > 1) {
+        uint64_t longest = 0;
+        for (const Stats &g : gemm_stats) longest = std::max(longest, g.total_cycles);
+        LOG_INFO("Batch: {} GEMMs, {:.1f} cycles per GEMM on average, longest {}", gemm_stats.size(),
+                 static_cast<double>(stats.total_cycles) / static_cast<double>(gemm_stats.size()), longest);
+    }
     LOG_INFO("Theoretical peak MACs: {}", (uint64_t)cfg_array_rows * (uint64_t)cfg_array_cols * stats.compute_cycles);
     LOG_INFO("Utilization: {:.2}%", get_utilization() * 100);
     LOG_INFO("Effective TOPS: {} GMACs/cycle", (double)stats.mac_operations / stats.total_cycles * 1e-9);
@@ -455,8 +1507,8 @@ void SystolicArray::load_config_cache() {
         const auto &c = cfg_opt.value();
         cfg_array_rows = c.array_rows > 0 ? c.array_rows : 8;
         cfg_array_cols = c.array_cols > 0 ? c.array_cols : 8;
-        cfg_tile_rows = c.tile_rows > 0 ? c.tile_rows : cfg_array_rows;
-        cfg_tile_cols = c.tile_cols > 0 ? c.tile_cols : cfg_array_cols;
+        cfg_tile_rows = std::max(0, c.tile_rows);
+        cfg_tile_cols = std::max(0, c.tile_cols);
         cfg_dataflow_cached = c.dataflow;
         // keep other knobs via legacy getters until they are added to Config
         cfg_unroll = get<int>("cube.unroll").value_or(1);
@@ -464,22 +1516,54 @@ void SystolicArray::load_config_cache() {
         cfg_trace_cycles = get<int>("cube.trace_cycles").value_or(0);
         cfg_pe_latency = get<int>("cube.pe_latency").value_or(1);
         cfg_verbose = get<bool>("cube.verbose").value_or(false);
+        cfg_threads = get<int>("cube.threads").value_or(1);
+        cfg_parallel_min_pes = get<int>("cube.parallel_min_pes").value_or(64 * 64);
     } else {
         // fallback to legacy getters
         cfg_array_rows = get<int>("cube.array_rows").value_or(8);
         cfg_array_cols = get<int>("cube.array_cols").value_or(8);
-        cfg_tile_rows = get<int>("cube.tile_rows").value_or(cfg_array_rows);
-        cfg_tile_cols = get<int>("cube.tile_cols").value_or(cfg_array_cols);
+        cfg_tile_rows = std::max(0, get<int>("cube.tile_rows").value_or(0));
+        cfg_tile_cols = std::max(0, get<int>("cube.tile_cols").value_or(0));
         cfg_unroll = get<int>("cube.unroll").value_or(1);
         cfg_progress_interval = get<int>("cube.progress_interval").value_or(0);
         cfg_trace_cycles = get<int>("cube.trace_cycles").value_or(0);
         cfg_pe_latency = get<int>("cube.pe_latency").value_or(1);
         cfg_verbose = get<bool>("cube.verbose").value_or(false);
-        cfg_dataflow_cached = get<Dataflow>("cube.dataflow").value_or(Dataflow::WEIGHT_STATIONARY);
+        cfg_dataflow_cached = get<Dataflow>("cube.dataflow").value_or(Dataflow::OUTPUT_STATIONARY);
+        cfg_threads = get<int>("cube.threads").value_or(1);
+        cfg_parallel_min_pes = get<int>("cube.parallel_min_pes").value_or(64 * 64);
             if (!err.empty()) {
                 LOG_WARN("load_config_cache: failed to load config '{}' : {}", config::get_default_path(), err);
             }
     }
+    // Fidelity and sampling knobs are not part of config::Config.
+    cfg_fidelity = get<Fidelity>("cube.fidelity").value_or(Fidelity::CYCLE);
+    cfg_sample_warmup = get<int>("cube.sample_warmup").value_or(2);
+    cfg_sample_tiles = get<int>("cube.sample_tiles").value_or(16);
+    cfg_sample_seed = get<int>("cube.sample_seed").value_or(1);
+    cfg_tile_cache = get<bool>("cube.tile_cache").value_or(false);
+    cfg_tile_cache_verify = get<bool>("cube.tile_cache_verify").value_or(false);
+    cfg_prefetch_descriptors = get<bool>("cube.prefetch_descriptors").value_or(true);
+    cfg_timed_writeback = get<bool>("cube.timed_writeback").value_or(false);
+    cfg_wcb_entries = std::max(1, get<int>("cube.wcb_entries").value_or(8));
+    cfg_wcb_burst = std::max(1, get<int>("cube.wcb_burst").value_or(64));
+    cfg_drain_overlap = get<bool>("cube.drain_overlap").value_or(true);
+    cfg_prefetch_depth = std::max(0, get<int>("cube.prefetch_depth").value_or(0));
+    cfg_tile_k = std::max(0, get<int>("cube.tile_k").value_or(0));
+    cfg_loop_order = get<LoopOrder>("cube.loop_order").value_or(LoopOrder::MNK);
+    switch (cfg_loop_order) {
+        case LoopOrder::MNK: loop_dims = {0, 1, 2}; break;
+        case LoopOrder::MKN: loop_dims = {0, 2, 1}; break;
+        case LoopOrder::NMK: loop_dims = {1, 0, 2}; break;
+        case LoopOrder::NKM: loop_dims = {1, 2, 0}; break;
+        case LoopOrder::KMN: loop_dims = {2, 0, 1}; break;
+        case LoopOrder::KNM: loop_dims = {2, 1, 0}; break;
+    }
+    cfg_k_accumulate = get<bool>("cube.k_accumulate").value_or(false);
+    if (cfg_k_accumulate && loop_dims[2] != 2) {
+        LOG_WARN("load_config_cache: cube.k_accumulate needs K as the innermost loop; disabled");
+        cfg_k_accumulate = false;
+    }
 }
 
 // Forward verify_result to the standalone utility implementation.
@@ -1,23 +1,43 @@
 #ifndef SYSTOLIC_ARRAY_H
 #define SYSTOLIC_ARRAY_H
 
+#include <array>
 #include <vector>
 #include <string>
 #include <iomanip>
 #include <memory>
 #include <deque>
+#include <functional>
+#include <map>
+#include <tuple>
 
 #include "types.h"
-#include "pe.h"
+#include "pe_grid.h"
 #include "fifo.h"
 #include "mem_if.h"
+#include "local_buffer.h"
+#include "dma.h"
 #include "clock.h"
+#include "static_clock.h"
+#include "perf_model.h"
+
+// One GEMM of a batch (SystolicArray::run_batch): C[M x N] += A[M x K] *
+// B[K x N], each matrix row-major with its own row stride in elements
+// (0: packed, i.e. lda = K and ldb = ldc = N).
+struct GemmDesc {
+    int M = 0, N = 0, K = 0;
+    Addr a_addr = 0, b_addr = 0, c_addr = 0;
+    int lda = 0, ldb = 0, ldc = 0;
+};
 
 // 脉动阵列核心
 class SystolicArray {
 private:
     // configuration path is read via runtime default; not stored here
-    std::vector<std::vector<PE>> pes;
+    // PE 阵列（SoA 整阵列引擎，由时钟统一驱动 tick/commit）
+    PEGrid grid;
+    // persistent host worker pool for band-parallel grid phases (cube.threads > 1)
+    std::shared_ptr<util::WorkerPool> workers;
 
     // 输入/输出FIFO（独占所有权，由 SystolicArray 管理）
     std::unique_ptr<FIFO> weight_fifo;
@@ -26,6 +46,10 @@ private:
 
     // 内存接口（共享给外部驱动/SimTop）
     p_mem_t memory;
+    // 片上本地缓冲（buffer.enabled）：复用的 A/B tile 不再访问 memory
+    std::unique_ptr<LocalBuffer> local_buffer;
+    // DMA 引擎：A/B tile 的读取作为描述符排队，由时钟阶段发往 memory
+    std::unique_ptr<DmaEngine> dma;
     
     // 控制器状态机
     enum class State {
@@ -40,15 +64,61 @@ private:
     Cycle current_cycle;
     // Global clock for the array.
     p_clock_t clock;
-    // listener ids registered with clock (if any)
-    std::size_t mem_listener_id;
-    std::size_t sa_listener_id;
-    std::size_t commit_listener_id;
-    // per-PE listener ids (same layout as pes)
-    std::vector<std::vector<std::size_t>> pe_listener_ids;
+    // 固定流水线阶段：Mem → PE tick → commit → controller（编译期顺序）
+    // (mem == nullptr: Mem is shared and ticked by its owner, see detach_pipeline)
+    struct MemStage {
+        Mem *mem = nullptr;
+        void cycle() { if (mem) mem->cycle(); }
+        void skip(Cycle n) { if (mem) mem->skip(n); }
+        Cycle cycles_until_event() const { return mem ? mem->cycles_until_event() : UINT64_MAX; }
+    };
+    struct PeStage {
+        PEGrid *grid = nullptr;
+        void cycle() { grid->tick(); }
+    };
+    struct CommitStage {
+        PEGrid *grid = nullptr;
+        void cycle() { grid->commit(); }
+    };
+    struct ControllerStage {
+        SystolicArray *sa = nullptr;
+        void cycle() { sa->cycle(); }
+        void skip(Cycle n) { sa->skip_cycles(n); }
+    };
+    // Issues write-combined result bursts to Mem in the background, so the
+    // drain of one tile overlaps the next tile's prefetch and compute.
+    struct WritebackStage {
+        SystolicArray *sa = nullptr;
+        void cycle() { sa->issue_writeback(); }
+        Cycle cycles_until_event() const { return sa->writeback_wake(); }
+    };
+    // Issues queued DMA transfers last, after the write-back stage, so reads
+    // see the issue slots left for this cycle.
+    struct DmaStage {
+        DmaEngine *dma = nullptr;
+        void cycle() { dma->cycle(); }
+        void skip(Cycle n) { dma->skip(n); }
+        Cycle cycles_until_event() const { return dma->cycles_until_event(); }
+    };
+    using Pipeline = StaticClock<MemStage, PeStage, CommitStage, ControllerStage, WritebackStage, DmaStage>;
+    Pipeline pipeline;
+    // the whole pipeline is mounted on the global clock as a single listener
+    std::size_t pipeline_listener_id;
+    // Shared Mem (detach_pipeline): the control loop advances the clock
+    // through the owner's hook.
+    std::function<Cycle(Cycle)> advance_hook;
+    // Result writes issued and not yet landed, counted through this array's
+    // own completion sink (Mem::has_pending() also sees other requesters).
+    int write_sink = -1;
+    uint64_t writes_in_flight = 0;
+    Cycle advance(Cycle limit = Clock::NEVER) { return advance_hook ? advance_hook(limit) : clock->advance(limit); }
+    // Let `n` idle cycles pass: a skip on an own clock, clock waits through
+    // the hook on a shared one (the other arrays keep running meanwhile).
+    void skip_clock(Cycle n);
     
+public:
     // 性能计数器
-    struct {
+    struct Stats {
         uint64_t total_cycles;
         uint64_t compute_cycles;
         uint64_t memory_stall_cycles;
@@ -57,7 +127,60 @@ private:
         uint64_t load_cycles;              // prefetch 等待周期
         uint64_t drain_cycles;             // 若有结果回写阶段的等待
         uint64_t memory_backpressure_cycles; // 因未完成请求过多而阻塞的周期
-    } stats;
+        uint64_t tile_cache_hits;          // tile 时序缓存命中（重放）次数
+        uint64_t tile_cache_misses;        // 可缓存但未命中、完整仿真的次数
+        uint64_t tile_cache_verify_failures; // verify 模式下重放与仿真不一致的次数
+        // 分 bank 内存（memory.banked）下 A 行 burst 与 B 子块各自的行命中/缺失与 bank 冲突等待
+        uint64_t a_row_hits;
+        uint64_t a_row_misses;
+        uint64_t a_bank_conflict_cycles;
+        uint64_t b_row_hits;
+        uint64_t b_row_misses;
+        uint64_t b_bank_conflict_cycles;
+        uint64_t writeback_bursts;         // 合并后发往 Mem 的累加器回写 burst 数（cube.timed_writeback）
+        // 本地缓冲（buffer.enabled）：按 A/B tile 计的命中/缺失，以及命中省下的主存读元素数
+        uint64_t buffer_hits;
+        uint64_t buffer_misses;
+        uint64_t buffer_saved_elems;
+        // 预取前瞻（cube.prefetch_depth）：后续 tile 的加载在途时的计算周期，
+        // 以及阵列轮到时数据已全部就位、无需等待的 tile 数
+        uint64_t prefetch_overlap_cycles;
+        uint64_t prefetch_ready_tiles;
+        uint64_t preload_cycles;           // 驻留数据流把驻留操作数移入阵列的周期（计入 compute）
+
+        bool operator==(const Stats &o) const {
+            return total_cycles == o.total_cycles && compute_cycles == o.compute_cycles &&
+                   memory_stall_cycles == o.memory_stall_cycles && mac_operations == o.mac_operations &&
+                   memory_accesses == o.memory_accesses && load_cycles == o.load_cycles &&
+                   drain_cycles == o.drain_cycles && memory_backpressure_cycles == o.memory_backpressure_cycles &&
+                   tile_cache_hits == o.tile_cache_hits && tile_cache_misses == o.tile_cache_misses &&
+                   tile_cache_verify_failures == o.tile_cache_verify_failures &&
+                   a_row_hits == o.a_row_hits && a_row_misses == o.a_row_misses &&
+                   a_bank_conflict_cycles == o.a_bank_conflict_cycles &&
+                   b_row_hits == o.b_row_hits && b_row_misses == o.b_row_misses &&
+                   b_bank_conflict_cycles == o.b_bank_conflict_cycles &&
+                   writeback_bursts == o.writeback_bursts && buffer_hits == o.buffer_hits &&
+                   buffer_misses == o.buffer_misses && buffer_saved_elems == o.buffer_saved_elems &&
+                   prefetch_overlap_cycles == o.prefetch_overlap_cycles &&
+                   prefetch_ready_tiles == o.prefetch_ready_tiles && preload_cycles == o.preload_cycles;
+        }
+        bool operator!=(const Stats &o) const { return !(*this == o); }
+    };
+    // a new counter must also be compared in Stats::operator==
+    static_assert(sizeof(Stats) == 24 * sizeof(uint64_t), "Stats::operator== misses a field");
+
+    // 采样模式的外推结果（总周期为估计值，附 95% 置信区间）
+    struct SampleReport {
+        uint64_t tiles_total;
+        uint64_t tiles_sampled;
+        double total_cycles;
+        double ci95_low;
+        double ci95_high;
+    };
+
+private:
+    Stats stats;
+    SampleReport sample_report;
     
     // 数据流控制变量
     int weight_load_ptr;
@@ -69,14 +192,106 @@ private:
     // Cached configuration values (loaded once per SystolicArray instance)
     int cfg_array_rows;
     int cfg_array_cols;
-    int cfg_tile_rows;
-    int cfg_tile_cols;
+    int cfg_tile_rows;          // cube.tile_rows: M extent of a tile (0: dataflow default)
+    int cfg_tile_cols;          // cube.tile_cols: N extent of a tile (0: dataflow default)
+    int cfg_tile_k;             // cube.tile_k: K extent of a tile (0: dataflow default)
+    LoopOrder cfg_loop_order;   // cube.loop_order: tile loop nesting
+    std::array<int, 3> loop_dims; // loop order as dimensions (0 = M, 1 = N, 2 = K), outermost first
+    bool cfg_k_accumulate;      // keep an output tile's sums in the array / output buffer across K
     int cfg_unroll;
     int cfg_progress_interval;
     int cfg_trace_cycles;
     int cfg_pe_latency;
     bool cfg_verbose;
     Dataflow cfg_dataflow_cached;
+    TileBlocks blocks;          // M/N/K extent of one tile for the dataflow
+    int cfg_threads;            // host threads for the PE grid (1 = serial)
+    int cfg_parallel_min_pes;   // smallest active window split into row bands
+    Fidelity cfg_fidelity;      // cube.fidelity: how run() models the GEMM
+    int cfg_sample_warmup;      // SAMPLED: leading tiles always simulated
+    int cfg_sample_tiles;       // SAMPLED: random interior tiles simulated
+    int cfg_sample_seed;        // SAMPLED: RNG seed for the interior pick
+    bool cfg_tile_cache;        // memoize tile timing by shape + idle memory
+    bool cfg_tile_cache_verify; // simulate cache hits anyway and compare
+    bool cfg_prefetch_descriptors; // B sub-block as one 2D strided read
+    bool cfg_timed_writeback;   // commit results through Mem instead of store_acc_direct
+    int cfg_wcb_entries;        // write-combining buffer depth (bursts)
+    int cfg_wcb_burst;          // longest merged burst (elements)
+    bool cfg_drain_overlap;     // let the drain run under the next tile
+    int cfg_prefetch_depth;     // tiles whose loads are issued ahead of the one computing
+
+    // Write-combining buffer for timed write-back: tile rows waiting to be
+    // issued, merged while contiguous. Issued from the front by WritebackStage.
+    struct WriteBurst {
+        Addr addr;
+        std::vector<AccType> vals;
+    };
+    std::deque<WriteBurst> wcb;
+
+    // 本地 FIFO 组：预取数据落在这里，由阵列边缘逐周期弹出。除当前组外还有
+    // cube.prefetch_depth 个影子组，接收后续 tile 的加载，与当前 tile 的计算重叠；
+    // 输出驻留 + cube.k_accumulate 时再多一组，保留上一个 K 块供下方各行取完尾部。
+    struct FifoSet {
+        std::vector<FIFO> a;    // A tile, one row or column per FIFO (see a_by_row)
+        std::vector<FIFO> b;    // B tile, one column or row per FIFO (see b_by_col)
+        int stream_a;           // Mem stream of a[0]; a[i] is stream_a + i
+        int stream_b;
+    };
+    std::vector<FifoSet> fifo_sets;
+
+    // A tile whose loads have been issued into a FIFO set: its DMA transfers
+    // and how many have not completed yet (decremented by the completion
+    // event), when the tiles served from the local buffer are in the FIFOs,
+    // and which operands missed it and are captured after the fetch.
+    struct TileLoad {
+        int gemm;               // batch index of the GEMM the tile belongs to
+        int mb, nb, kb;
+        int m_tile, n_tile, k_tile;
+        int set;
+        uint32_t a_id;
+        uint32_t b_id;
+        int pending;
+        Cycle buffer_ready_cycle;
+        bool fill_a;
+        bool fill_b;
+    };
+    // Issued loads in tile order; the front one belongs to the tile being
+    // (or about to be) computed.
+    std::deque<TileLoad> tile_loads;
+    void submit_dma(int channel, const DmaEngine::Descriptor &desc, TileLoad &load, uint32_t &id);
+    void issue_lookahead(size_t limit);
+    bool lookahead_in_flight() const;
+    void discard_tile_loads();
+
+    void fill_local_buffer(const TileLoad &load);
+
+    // Tile timing memo: stat deltas of a tile that started and ended with an
+    // idle Mem, keyed by (m_tile, n_tile, k_tile).
+    struct TileTiming {
+        Cycle cycles;
+        uint64_t compute_cycles;
+        uint64_t memory_stall_cycles;
+        uint64_t memory_accesses;
+        uint64_t load_cycles;
+        uint64_t drain_cycles;
+        uint64_t memory_backpressure_cycles;
+        uint64_t mac_operations;    // data dependent: a hit books its own tile's, from the host data
+        bool operator==(const TileTiming &o) const {
+            return cycles == o.cycles && compute_cycles == o.compute_cycles &&
+                   memory_stall_cycles == o.memory_stall_cycles && memory_accesses == o.memory_accesses &&
+                   load_cycles == o.load_cycles && drain_cycles == o.drain_cycles &&
+                   memory_backpressure_cycles == o.memory_backpressure_cycles &&
+                   mac_operations == o.mac_operations;
+        }
+    };
+    std::map<std::tuple<int, int, int>, TileTiming> tile_cache;
+    TileTiming timing_since(const Stats &before) const;
+    void replay_tile_timing(const TileTiming &t);
+    // Host computation of one tile's partial sums, committed like commit_tile_results.
+    bool compute_tile_functional(int mb, int nb, int kb, int m_tile, int n_tile, int k_tile);
+    bool load_tile(int mb, int nb, int kb, int m_tile, int n_tile, int k_tile,
+                   std::vector<DataType> &a, std::vector<DataType> &b) const;
+    bool simulate_tile(int mb, int nb, int kb);
 
     // Load configuration values from file into cached members
     void load_config_cache();
@@ -90,36 +305,111 @@ private:
     void shift_activations_right();
     void shift_partial_sums_down();
 
-    // 复用的 completion 队列池，避免重复分配
-    std::vector<std::shared_ptr<std::deque<DataType>>> completionA_pool;
-    std::vector<std::shared_ptr<std::deque<DataType>>> completionB_pool;
+    // Tile-loop position of the current run (next tile to process). Kept as
+    // plain data so it can be written into a checkpoint. The geometry is
+    // that of batch[gemm], the GEMM being computed.
+    struct RunPosition {
+        int M, N, K;
+        Addr a_addr, b_addr, c_addr;
+        int lda, ldb, ldc;
+        int gemm;
+        int mb, nb, kb;
+        int tiles_done, tiles_total;    // over the whole batch
+        bool active;
+    } run_pos;
+    static constexpr uint32_t kCheckpointVersion = 13;
+
+    // GEMMs of the current run in order (strides resolved); a plain run is
+    // a batch of one. gemm_stats[g] holds the stat deltas over the stretch
+    // in which GEMM g was the one computing (its write-back drain included
+    // for the last one); gemm_mark is the snapshot that stretch started at.
+    std::vector<GemmDesc> batch;
+    std::vector<Stats> gemm_stats;
+    Stats gemm_mark;
+    bool set_batch(const std::vector<GemmDesc> &gemms);
+    void enter_gemm(int gemm);
+    void close_gemm(int gemm);
+    static Stats stats_delta(const Stats &now, const Stats &before);
+
+    void advance_tile_position();
+    // Step (mb, nb, kb) to the next tile of `g` in loop order; false past its last one.
+    bool next_tile_position(const GemmDesc &g, int &mb, int &nb, int &kb) const;
+    // The tile opens a new iteration of the outermost loop (both inner
+    // positions at 0).
+    bool starts_outer_loop(int mb, int nb, int kb) const;
+
+    // K accumulation (cube.k_accumulate, K innermost): the K chunks of an
+    // output tile run back to back and its results commit once, after the
+    // last chunk. Output-stationary keeps the sums in the PE accumulators
+    // and streams the chunks without a fill / drain in between, so a chunk
+    // after the first keeps the previous chunk's FIFO set at the front of
+    // tile_loads until the lower rows have taken its tail. The stationary
+    // dataflows must still preload every chunk and add into tile_out.
+    // Sampled runs visit chunks out of order and never accumulate.
+    bool accumulate_k() const { return cfg_k_accumulate && cfg_fidelity != Fidelity::SAMPLED; }
+    bool holds_previous_chunk(int kb) const {
+        return accumulate_k() && kb > 0 && cfg_dataflow_cached == Dataflow::OUTPUT_STATIONARY;
+    }
+
+    // Operand layout in a FIFO set for the dataflow. Output- and
+    // input-stationary keep row i of the A tile in a[i], weight-stationary
+    // keeps column kk in a[kk] (one FIFO per array row it enters). B column
+    // j goes to b[j], except input-stationary, which streams row kk of B
+    // into array row kk from b[kk].
+    bool a_by_row() const { return cfg_dataflow_cached != Dataflow::WEIGHT_STATIONARY; }
+    bool b_by_col() const { return cfg_dataflow_cached != Dataflow::INPUT_STATIONARY; }
+
+    // Results of a stationary-dataflow tile, collected (row-major m x n) as
+    // they leave the bottom of the array.
+    std::vector<AccType> tile_out;
+    AccType tile_result(int i, int j, int n_tile) const {
+        return cfg_dataflow_cached == Dataflow::OUTPUT_STATIONARY ? grid.accumulator(i, j)
+                                                                  : tile_out[static_cast<size_t>(i) * n_tile + j];
+    }
 
     // Helpers for tile execution (small, single-responsibility)
     void init_tile_state(int m_tile, int n_tile);
     bool execute_tile_cycles(std::vector<FIFO>& localA_pool,
                              std::vector<FIFO>& localB_pool,
                              int m_tile, int n_tile, int k_tile);
+    bool execute_stationary_tile(std::vector<FIFO>& localA_pool,
+                                 std::vector<FIFO>& localB_pool,
+                                 int m_tile, int n_tile, int k_tile, bool add_to_out);
+    bool execute_accumulating_chunk(FifoSet *prev, FifoSet &cur,
+                                    int kb, int m_tile, int n_tile, int k_tile);
     void commit_tile_results(int mb, int nb, int m_tile, int n_tile,
-                             uint32_t c_addr, int N);
+                             Addr c_addr, int ldc);
 
-    // New helpers to support memory-driven runs.
-    bool issue_prefetch_for_tile(int mb, int nb, int kb, int m_tile, int n_tile, int k_tile,
-                                 int A_cols, int B_cols,
-                                 uint32_t a_addr, uint32_t b_addr,
-                                 std::vector<FIFO>& localA_pool,
-                                 std::vector<FIFO>& localB_pool,
-                                 std::vector<std::shared_ptr<std::deque<DataType>>>& completionA,
-                                 std::vector<std::shared_ptr<std::deque<DataType>>>& completionB,
-                                 size_t queue_depth);
-
-    bool wait_for_prefetch(int m_tile, int n_tile, int k_tile,
-                           std::vector<FIFO>& localA_pool,
-                           std::vector<FIFO>& localB_pool);
-
-    bool process_tile(std::vector<FIFO>& localA_pool,
-                                  std::vector<FIFO>& localB_pool,
-                                  int mb, int nb, int m_tile, int n_tile, int k_tile,
-                                  uint32_t c_addr, int N);
+    // New helpers to support memory-driven runs. A lookahead issue backs
+    // off (returns false) when no FIFO set or DMA queue entry is free.
+    bool issue_prefetch_for_tile(int gemm, int mb, int nb, int kb, bool lookahead);
+
+    bool wait_for_prefetch(const TileLoad &load);
+
+    // Timed write-back: queue one tile row, issue queued bursts, next wake-up
+    // for the stage, and wait until all results have landed in memory.
+    void enqueue_writeback(Addr addr, const AccType *vals, int len);
+    void issue_writeback();
+    Cycle writeback_wake() const;
+    void flush_writeback();
+    // Bulk accounting for idle cycles skipped by an event-driven Clock.
+    void skip_cycles(Cycle n);
+
+    // Fidelity::ANALYTICAL path of run() over `batch`: closed-form cycle estimate only.
+    bool run_analytical();
+    // Fidelity::SAMPLED path of run(): simulate a tile sample, extrapolate the rest.
+    bool run_sampled(int M, int N, int K,
+                     Addr a_addr, Addr b_addr, Addr c_addr);
+    bool run_tile(int mb, int nb, int kb);
+    // Fidelity::FUNCTIONAL path of run() over `batch`: host GEMM, results only.
+    bool run_functional();
+    // Gather `rows` x `cols` elements with row stride `ld` (functional access).
+    bool load_rows(Addr addr, int rows, int cols, int ld, DataType *dst) const;
+
+    // Compute the tile whose loads are `load` (prev: the held previous K
+    // chunk, see holds_previous_chunk) and commit it unless more K chunks
+    // accumulate into it.
+    bool process_tile(const TileLoad &load, const TileLoad *prev);
     
 public:
     SystolicArray(p_clock_t external_clock,
@@ -137,7 +427,47 @@ public:
     // accumulator results back into memory via `store_acc_direct` at offsets
     // starting at `c_addr`.
     bool run(int M, int N, int K,
-                         uint32_t a_addr, uint32_t b_addr, uint32_t c_addr);
+                         Addr a_addr, Addr b_addr, Addr c_addr);
+
+    // Incremental form of `run`: begin_run sets up the tile loop, resume
+    // processes at most `max_tiles` tiles (all remaining when negative) and
+    // returns at a tile boundary. finished() turns true after the last tile.
+    bool begin_run(int M, int N, int K,
+                   Addr a_addr, Addr b_addr, Addr c_addr);
+    bool resume(int max_tiles = -1);
+    bool finished() const { return current_state == State::DONE; }
+
+    // Run a batch of GEMMs back to back as one tile stream: the array is set
+    // up once, lookahead prefetch (cube.prefetch_depth) runs on into the next
+    // GEMM's first tiles and the local buffer keeps its contents across
+    // GEMMs. get_stats() covers the whole batch, get_gemm_stats() each GEMM.
+    // begin_batch is the incremental form (continue with resume()). Sampled
+    // fidelity is not batched: the batch is simulated cycle by cycle.
+    bool run_batch(const std::vector<GemmDesc> &gemms);
+    bool begin_batch(const std::vector<GemmDesc> &gemms);
+    const std::vector<Stats>& get_gemm_stats() const { return gemm_stats; }
+
+    // Several arrays on one Mem (AIC with aic.cubes > 1). detach_pipeline()
+    // takes the pipeline off the clock and stops it driving Mem: the owner
+    // ticks Mem once per cycle and then every array's pipeline, in the order
+    // it arbitrates Mem's issue slots by. Clock waits of the control loop go
+    // through `hook`, which must advance the clock by at least one and at
+    // most `limit` cycles and returns the cycles elapsed. The tile cache is
+    // turned off: a tile's timing depends on the other arrays' traffic.
+    void detach_pipeline(std::function<Cycle(Cycle limit)> hook);
+    void tick_pipeline() { pipeline.tick(); }
+    void skip_pipeline(Cycle n) { pipeline.skip(n); }
+    Cycle pipeline_wake() const { return pipeline.cycles_until_event(); }
+
+    // 仿真精度（默认取自 cube.fidelity）；只影响 run()，begin_run/resume 始终逐周期。
+    void set_fidelity(Fidelity f) { cfg_fidelity = f; }
+    Fidelity get_fidelity() const { return cfg_fidelity; }
+    PerfModelParams perf_model_params() const;
+
+    // 检查点：把时钟、内存（含未完成请求）、累加器内存、PE 寄存器、FIFO 与
+    // tile 循环位置写入紧凑二进制快照；加载后可用 resume() 继续或分叉运行。
+    bool save_checkpoint(const std::string &path) const;
+    bool load_checkpoint(const std::string &path);
     
     // 单周期推进
     void cycle();
@@ -147,6 +477,8 @@ public:
     Cycle get_cycle() const { return current_cycle; }
     
     // 性能统计
+    const Stats& get_stats() const { return stats; }
+    const SampleReport& get_sample_report() const { return sample_report; }
     void print_stats() const;
     double get_utilization() const;
     double get_memory_efficiency() const;
@@ -156,22 +488,4 @@ public:
     void enable_tracing(const std::string& filename); 
 };
 
-// 内存模型
-class DoubleBufferedMemory {
-private:
-    std::vector<DataType> bank_a;
-    std::vector<DataType> bank_b;
-    bool active_bank;  // true=A, false=B
-    int buffer_size;
-    
-public:
-    DoubleBufferedMemory(int size);
-    
-    void switch_bank() { active_bank = !active_bank; }
-    // Buffer accessors removed: not used in project API surface.
-    
-    void load_data(const std::vector<DataType>& data, int offset);
-    std::vector<DataType> read_data(int offset, int size) const;
-};
-
 #endif // SYSTOLIC_ARRAY_H
\ No newline at end of file
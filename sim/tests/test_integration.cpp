@@ -4,8 +4,15 @@
 #include <vector>
 #include <random>
 #include <chrono>
+#include <cmath>
+#include <iomanip>
 #include "systolic.h"
+#include "pe.h"
+#include "pe_grid.h"
+#include "static_clock.h"
 #include "aic.h"
+#include "cube.h"
+#include "mem_trace.h"
 #include "config/config.h"
 
 #include <gtest/gtest.h>
@@ -14,13 +21,94 @@
 #include "util/utils.h"
 #include <filesystem>
 #include <cstdlib>
+#include <optional>
 
 // 文件：tests/test_integration.cpp
-// Ensure tests use the repo-wide default config path via a test fixture
+// All tests run on the `Integration` fixture: it points the runtime config at
+// model_cfg.toml before and after every test (also when an ASSERT_* ended it
+// early), so a temporary config installed by use_config() never leaks into the
+// next test, and it provides the shared GEMM setup / run / read-back steps.
 class Integration : public ::testing::Test {
 protected:
     Integration() { config::set_default_path("model_cfg.toml"); }
-    ~Integration() override = default;
+    ~Integration() override { config::set_default_path("model_cfg.toml"); }
+
+    // tests/cases under the working directory, created on first use.
+    static std::string case_dir() {
+        auto dir = (std::filesystem::current_path() / "tests" / "cases").string();
+        std::filesystem::create_directories(dir);
+        return dir;
+    }
+
+    // Write `body` to tests/cases/<name> and make it the runtime config.
+    static void use_config(const std::string &name, const std::string &body) {
+        const std::string path = case_dir() + "/" + name;
+        {
+            std::ofstream fout(path);
+            fout << body;
+        }
+        config::set_default_path(path);
+    }
+
+    // A random GEMM, its reference result and the operand addresses
+    // (A at 0, B right after it, C at 0 unless a test moves them).
+    struct Gemm {
+        int M = 0, N = 0, K = 0;
+        Addr a_addr = 0, b_addr = 0, c_addr = 0;
+        std::vector<DataType> A, B;
+        std::vector<AccType> golden;
+    };
+    static Gemm random_gemm(int M, int N, int K, int min_val = -128, int max_val = 127) {
+        Gemm g;
+        g.M = M;
+        g.N = N;
+        g.K = K;
+        g.b_addr = static_cast<Addr>(M) * static_cast<Addr>(K);
+        g.A = util::generate_random_matrix(M, K, min_val, max_val);
+        g.B = util::generate_random_matrix(K, N, min_val, max_val);
+        g.golden = util::compute_reference(g.A, M, K, g.B, N);
+        return g;
+    }
+
+    // A Mem on `clk` holding the GEMM's A and B.
+    static p_mem_t load_mem(const p_clock_t &clk, const Gemm &g) {
+        auto mem = std::make_shared<Mem>(clk);
+        mem->pv_write(reinterpret_cast<uint64_t>(g.A.data()), g.A.size(), g.a_addr);
+        mem->pv_write(reinterpret_cast<uint64_t>(g.B.data()), g.B.size(), g.b_addr);
+        return mem;
+    }
+
+    static std::vector<AccType> read_c(const p_mem_t &mem, const Gemm &g) {
+        std::vector<AccType> C(static_cast<size_t>(g.M) * static_cast<size_t>(g.N));
+        EXPECT_TRUE(mem->pv_read(g.c_addr, C.size(), reinterpret_cast<uint64_t>(C.data())));
+        return C;
+    }
+
+    // One Cube run of a GEMM on a fresh clock (event driven if asked) and
+    // memory under the current config; the clock, memory and cube stay alive
+    // for inspection. C is read back unless the run was ANALYTICAL (which
+    // writes no results).
+    struct CubeRun {
+        p_clock_t clk;
+        p_mem_t mem;
+        p_cube_t cube;
+        bool ok = false;
+        std::vector<AccType> C;
+        Cycle cycles() const { return clk->now(); }
+        const SystolicArray::Stats &stats() const { return cube->get_stats(); }
+    };
+    static CubeRun run_cube(const Gemm &g, std::optional<Fidelity> fidelity = std::nullopt,
+                            bool event_driven = false) {
+        CubeRun r;
+        r.clk = std::make_shared<Clock>();
+        r.clk->set_event_driven(event_driven);
+        r.mem = load_mem(r.clk, g);
+        r.cube = std::make_shared<Cube>(r.clk, r.mem);
+        if (fidelity) r.cube->set_fidelity(*fidelity);
+        r.ok = r.cube->run(g.M, g.N, g.K, g.a_addr, g.b_addr, g.c_addr);
+        if (r.ok && r.cube->get_fidelity() != Fidelity::ANALYTICAL) r.C = read_c(r.mem, g);
+        return r;
+    }
 };
 
 // 集成测试：SmallMatrix
@@ -93,30 +181,48 @@ TEST_F(Integration, QuickLarge) {
     EXPECT_TRUE(ret);
 }
 
-// 目的：验证不同数据流策略（WEIGHT/OUTPUT/INPUT stationary）对阵列行为的影响。
-// 说明：该测试较为耗时，会对同一输入在不同 dataflow 配置下运行完整仿真。
-// 默认以 DISABLED_ 前缀禁用；需要时通过 `--gtest_filter` 或取消 DISABLED_ 前缀启用。
-// 运行说明：使用 `ctest` 或直接运行测试二进制来执行该用例。
+// 目的：验证三种数据流（OUTPUT/WEIGHT/INPUT stationary）各自的调度：结果均与参考一致，
+// 周期数与解析模型的逐数据流公式一致，且驻留数据流需要额外的预装载周期。
+// 阵列取非方形，覆盖按行 / 按列分配 FIFO 的不同布局。
+// 稀疏输入下，功能模式按数据流统计的有效 MAC 数与逐周期仿真一致。
 TEST_F(Integration, DataflowModes) {
-    auto case_dir = (std::filesystem::current_path() / "tests" / "cases").string();
-    // Use case TOML to run this (still disabled by default)
-    std::string case_toml = case_dir + std::string("/case_DataflowModes.toml");
-    util::CaseConfig case_cfg;
-    bool have_case = util::read_case_toml(case_toml, case_cfg);
-    int M = 64, K = 64, N = 64;
-    auto A = util::generate_random_matrix(M,K);
-    auto B = util::generate_random_matrix(K,N);
+    Gemm g = random_gemm(45, 50, 39);
+    // A and B sparse in different proportions: the useful MACs then depend on
+    // which operand streams through the array
+    for (size_t i = 0; i < g.A.size(); i += 3) g.A[i] = 0;
+    for (size_t i = 0; i < g.B.size(); i += 2) g.B[i] = 0;
+    g.golden = util::compute_reference(g.A, g.M, g.K, g.B, g.N);
+    const char *modes[] = {"OUTPUT_STATIONARY", "WEIGHT_STATIONARY", "INPUT_STATIONARY"};
+    SystolicArray::Stats s[3];
+    for (int d = 0; d < 3; ++d) {
+        use_config("dataflow_cfg.toml", std::string("[cube]\narray_rows = 8\narray_cols = 12\ndataflow = \"") + modes[d] +
+                                            "\"\n[memory]\nmemory_latency = 9\nbandwidth = 4\n");
+        const CubeRun r = run_cube(g);
+        ASSERT_TRUE(r.ok) << modes[d];
+        EXPECT_EQ(r.C, g.golden) << modes[d];
+        s[d] = r.stats();
+        const CubeRun functional = run_cube(g, Fidelity::FUNCTIONAL);
+        ASSERT_TRUE(functional.ok) << modes[d];
+        EXPECT_EQ(functional.stats().mac_operations, s[d].mac_operations) << modes[d];
 
-    if (!have_case) {
-        util::create_case_toml(case_toml, case_cfg, case_dir, std::string("Dataflow"), A, B, M, K, N);
+        PerfModelParams p;
+        p.array_rows = 8;
+        p.array_cols = 12;
+        p.mem_latency = 9;
+        p.bandwidth = 4;
+        p.max_outstanding = 36;
+        p.dataflow = *get<Dataflow>("cube.dataflow");
+        const PerfEstimate e = estimate_gemm(p, g.M, g.N, g.K);
+        EXPECT_EQ(s[d].total_cycles, e.total_cycles) << modes[d];
+        EXPECT_EQ(s[d].compute_cycles, e.compute_cycles) << modes[d];
     }
-
-    auto clk_w = std::make_shared<Clock>();
-    auto memory_w = std::make_shared<Mem>(clk_w);
-    auto aic_w = std::make_shared<AIC>(clk_w, memory_w);
-    aic_w->build(case_toml);
-    auto ret = aic_w->start();
-    EXPECT_TRUE(ret);
+    EXPECT_EQ(s[0].preload_cycles, 0u);
+    EXPECT_GT(s[1].preload_cycles, 0u);
+    EXPECT_GT(s[2].preload_cycles, 0u);
+    EXPECT_NE(s[0].total_cycles, s[1].total_cycles);
+    EXPECT_NE(s[1].total_cycles, s[2].total_cycles);
+    EXPECT_EQ(s[1].mac_operations, s[0].mac_operations);
+    EXPECT_NE(s[2].mac_operations, s[0].mac_operations);
 }
 
 // 目的：测试不同阵列尺寸（4、8、16、32 等）下的矩阵乘法可扩展性与正确性。
@@ -144,3 +250,796 @@ TEST_F(Integration, Scaling) {
 }
 
 
+// 目的：验证事件驱动（skip-ahead）时钟与逐周期 tick 的结果和周期数完全一致。
+// 说明：使用较大的 memory_latency，使预取等待与排空阶段存在大量空闲周期。
+TEST_F(Integration, EventDrivenClock) {
+    use_config("event_driven_cfg.toml", "[cube]\narray_rows = 8\narray_cols = 8\n[memory]\nmemory_latency = 200\nbandwidth = 4\n");
+
+    const Gemm g = random_gemm(20, 20, 24);
+    const CubeRun tick = run_cube(g, std::nullopt, false);
+    const CubeRun event = run_cube(g, std::nullopt, true);
+    ASSERT_TRUE(tick.ok);
+    ASSERT_TRUE(event.ok);
+    EXPECT_EQ(tick.C, g.golden);
+    EXPECT_EQ(event.C, tick.C);
+    EXPECT_EQ(tick.cycles(), event.cycles());
+    // every counter, not just the end cycle: skipped spans must book the same stalls
+    EXPECT_TRUE(tick.stats() == event.stats());
+}
+
+// 目的：验证 SoA 整阵列引擎 `PEGrid` 与逐个 `PE` 的两阶段提交逐位一致。
+// 说明：随机边界输入驱动若干周期，逐周期比较累加器、激活与权重寄存器。
+TEST(PEGridTest, MatchesScalarPE) {
+    const int R = 6, C = 11, T = 40;
+    std::mt19937 gen(1234);
+    std::uniform_int_distribution<int> val(-128, 127);
+    std::uniform_int_distribution<int> coin(0, 3);
+
+    PEGrid grid(R, C);
+    std::vector<std::vector<PE>> pes(R, std::vector<PE>(C));
+    for (int i = 0; i < R; ++i) for (int j = 0; j < C; ++j) pes[i][j] = PE(i, j);
+    grid.begin_tile(R, C);
+
+    std::vector<DataType> left(R), top(C);
+    std::vector<char> top_valid(C);
+    for (int t = 0; t < T; ++t) {
+        for (int i = 0; i < R; ++i) left[i] = coin(gen) ? static_cast<DataType>(val(gen)) : 0;
+        for (int j = 0; j < C; ++j) { top_valid[j] = coin(gen) != 0; top[j] = static_cast<DataType>(val(gen)); }
+
+        for (int i = 0; i < R; ++i) {
+            for (int j = 0; j < C; ++j) {
+                DataType act_in = j > 0 ? pes[i][j-1].get_activation() : left[i];
+                DataType w_in = i > 0 ? pes[i-1][j].get_weight() : top[j];
+                bool w_present = i > 0 ? pes[i-1][j].has_weight() : top_valid[j] != 0;
+                pes[i][j].prepare_inputs(act_in, pes[i][j].get_accumulator(), w_in, w_present);
+            }
+        }
+        const uint64_t grid_macs = grid.prepare(left.data(), top.data(), top_valid.data());
+        for (auto &row : pes) for (auto &pe : row) pe.tick();
+        // the reference MAC count is what the scalar PEs actually multiplied
+        uint64_t ref_macs = 0;
+        for (auto &row : pes) for (auto &pe : row) ref_macs += pe.did_mac() ? 1 : 0;
+        EXPECT_EQ(grid_macs, ref_macs);
+        grid.tick();
+        for (auto &row : pes) for (auto &pe : row) pe.commit();
+        grid.commit();
+
+        for (int i = 0; i < R; ++i) {
+            for (int j = 0; j < C; ++j) {
+                ASSERT_EQ(grid.accumulator(i, j), pes[i][j].get_accumulator());
+                ASSERT_EQ(grid.activation(i, j), pes[i][j].get_activation());
+                ASSERT_EQ(grid.has_weight(i, j), pes[i][j].has_weight());
+                if (pes[i][j].has_weight()) {
+                    ASSERT_EQ(grid.weight(i, j), pes[i][j].get_weight());
+                }
+            }
+        }
+    }
+}
+
+// 目的：验证 `StaticClock` 按模板参数顺序执行各阶段，并正确转发 skip 与唤醒查询。
+namespace {
+struct TraceStage {
+    std::string *log; char tag;
+    void cycle() { log->push_back(tag); }
+};
+struct TimerStage {
+    Cycle remaining = 5; Cycle skipped = 0;
+    void cycle() { if (remaining) remaining--; }
+    void skip(Cycle n) { remaining -= n; skipped += n; }
+    Cycle cycles_until_event() const { return remaining; }
+};
+} // namespace
+
+TEST(StaticClockTest, StageOrderAndSkip) {
+    std::string log;
+    StaticClock<TraceStage, TimerStage, TraceStage> sc(TraceStage{&log, 'a'}, TimerStage{}, TraceStage{&log, 'b'});
+    sc.tick();
+    sc.tick();
+    EXPECT_EQ(log, "abab");
+    EXPECT_EQ(sc.cycles_until_event(), 3u);
+    sc.skip(2);
+    EXPECT_EQ(sc.now(), 4u);
+    EXPECT_EQ(sc.stage<1>().skipped, 2u);
+    EXPECT_EQ(sc.cycles_until_event(), 1u);
+    EXPECT_EQ(log, "abab");
+}
+
+// 目的：验证按行带并行的 PE 阵列（cube.threads > 1）与串行执行结果、周期数一致，
+// 且各行带归约后的 MAC 数及其余统计计数完全相同（丢失或重复计入某一行带都会被发现）。
+TEST_F(Integration, ParallelGrid) {
+    const Gemm g = random_gemm(40, 40, 36);
+    const char *cube_keys[2] = {"", "threads = 4\nparallel_min_pes = 16\n"};
+    std::vector<CubeRun> runs;
+    for (const char *keys : cube_keys) {
+        use_config("parallel_cfg.toml", std::string("[cube]\narray_rows = 16\narray_cols = 16\n") + keys);
+        runs.push_back(run_cube(g));
+        ASSERT_TRUE(runs.back().ok) << keys;
+        EXPECT_EQ(runs.back().C, g.golden) << keys;
+    }
+    EXPECT_GT(runs[0].stats().mac_operations, 0u);
+    EXPECT_EQ(runs[0].cycles(), runs[1].cycles());
+    EXPECT_EQ(runs[0].stats(), runs[1].stats());
+}
+
+// 检查点：运行若干 tile 后保存快照，在全新的 clock/mem/cube 上恢复并跑完，
+// 结果与周期数需与一次性运行完全一致（计时写回时快照中含在途的结果写）。
+TEST_F(Integration, CheckpointResumeMatchesFullRun) {
+    Gemm g = random_gemm(20, 20, 20);
+    g.b_addr = 4096;
+    const char *writeback_keys[2] = {"", "timed_writeback = true\nprefetch_depth = 2\n"};
+    for (const char *keys : writeback_keys) {
+        use_config("checkpoint_cfg.toml", std::string("[cube]\narray_rows = 8\narray_cols = 8\n") + keys +
+                                              "[memory]\nmemory_latency = 60\nbandwidth = 1\n");
+        const CubeRun full = run_cube(g);
+        ASSERT_TRUE(full.ok) << keys;
+        EXPECT_EQ(full.C, g.golden) << keys;
+
+        std::string snap = case_dir() + std::string("/checkpoint.snap");
+        {
+            auto clk = std::make_shared<Clock>();
+            auto mem = load_mem(clk, g);
+            Cube cube(clk, mem);
+            ASSERT_TRUE(cube.start_run(g.M, g.N, g.K, g.a_addr, g.b_addr, g.c_addr));
+            ASSERT_TRUE(cube.resume(3));
+            EXPECT_FALSE(cube.finished());
+            ASSERT_TRUE(cube.save_checkpoint(snap));
+        }
+        {
+            auto clk = std::make_shared<Clock>();
+            auto mem = std::make_shared<Mem>(clk);
+            Cube cube(clk, mem);
+            ASSERT_TRUE(cube.load_checkpoint(snap));
+            ASSERT_TRUE(cube.resume());
+            EXPECT_TRUE(cube.finished());
+            EXPECT_EQ(clk->now(), full.cycles()) << keys;
+            EXPECT_EQ(read_c(mem, g), full.C) << keys;
+        }
+    }
+}
+
+// 校准：解析模型（Fidelity::ANALYTICAL）与逐周期仿真在若干配置下的总周期误差。
+// 误差逐项输出，便于在修改 Mem/阵列时序后重新校准模型。
+TEST_F(Integration, PerfModelCalibrationAgainstCycleMode) {
+    struct Point { int rows, cols, latency, bandwidth, max_outstanding, M, N, K; };
+    const Point points[] = {
+        {8, 8, 10, 4, 0, 40, 40, 40},
+        {16, 16, 50, 4, 0, 48, 48, 48},
+        {16, 16, 10, 8, 0, 50, 70, 90},
+        {8, 8, 10, 4, 16, 33, 17, 29},
+        {4, 4, 5, 1, 0, 20, 30, 40},
+    };
+    for (const auto &pt : points) {
+        std::ostringstream cfg;
+        cfg << "[cube]\narray_rows = " << pt.rows << "\narray_cols = " << pt.cols << "\n";
+        cfg << "[memory]\nmemory_latency = " << pt.latency << "\nbandwidth = " << pt.bandwidth
+            << "\nmax_outstanding = " << pt.max_outstanding << "\n";
+        cfg << "[clock]\nevent_driven = true\n";
+        use_config("perf_model_cfg.toml", cfg.str());
+        const Gemm g = random_gemm(pt.M, pt.N, pt.K);
+
+        SystolicArray::Stats s[2];
+        const Fidelity modes[2] = {Fidelity::CYCLE, Fidelity::ANALYTICAL};
+        for (int r = 0; r < 2; ++r) {
+            const CubeRun run = run_cube(g, modes[r]);
+            ASSERT_TRUE(run.ok);
+            s[r] = run.stats();
+            EXPECT_EQ(run.cycles(), s[r].total_cycles);
+        }
+        double err = (static_cast<double>(s[1].total_cycles) - static_cast<double>(s[0].total_cycles)) /
+                     static_cast<double>(s[0].total_cycles);
+        std::cout << "[perf_model] " << pt.rows << "x" << pt.cols << " lat=" << pt.latency
+                  << " bw=" << pt.bandwidth << " GEMM " << pt.M << "x" << pt.N << "x" << pt.K
+                  << ": cycle=" << s[0].total_cycles << " analytical=" << s[1].total_cycles
+                  << " error=" << std::fixed << std::setprecision(2) << err * 100.0 << "%\n";
+        EXPECT_EQ(s[1].compute_cycles, s[0].compute_cycles);
+        EXPECT_LT(std::abs(err), 0.05);
+    }
+}
+
+// 功能模式：宿主分块 GEMM 的累加器结果必须与逐周期仿真逐位一致，
+// 并覆盖非整块尺寸、奇数 K 与多线程分片。
+TEST_F(Integration, FunctionalModeBitIdenticalToCycleMode) {
+    use_config("functional_cfg.toml", "[cube]\narray_rows = 8\narray_cols = 8\nthreads = 4\n[clock]\nevent_driven = true\n");
+    Gemm g = random_gemm(70, 300, 37, -32768, 32767);
+    g.c_addr = 16;
+
+    const CubeRun cycle = run_cube(g, Fidelity::CYCLE);
+    const CubeRun functional = run_cube(g, Fidelity::FUNCTIONAL);
+    ASSERT_TRUE(cycle.ok);
+    ASSERT_TRUE(functional.ok);
+    EXPECT_EQ(cycle.C, functional.C);
+}
+
+// 采样模式：只逐周期仿真少量 tile，其余功能计算并外推；
+// 结果逐位一致，外推总周期与完整逐周期仿真的误差应很小且落在置信区间附近。
+// 计时写回时最后一个采样 tile 的结果留在写合并缓冲中，也须在外推前排空。
+TEST_F(Integration, SampledModeExtrapolatesCycleMode) {
+    const Gemm g = random_gemm(70, 50, 60);
+    const char *writeback_keys[2] = {"", "timed_writeback = true\n"};
+    for (const char *keys : writeback_keys) {
+        use_config("sampled_cfg.toml", std::string("[cube]\narray_rows = 8\narray_cols = 8\nsample_warmup = 2\nsample_tiles = 12\n") +
+                                           keys + "[memory]\nmemory_latency = 20\nbandwidth = 4\n[clock]\nevent_driven = true\n");
+        const CubeRun cycle = run_cube(g, Fidelity::CYCLE);
+        const CubeRun sampled = run_cube(g, Fidelity::SAMPLED);
+        ASSERT_TRUE(cycle.ok) << keys;
+        ASSERT_TRUE(sampled.ok) << keys;
+        const SystolicArray::SampleReport &report = sampled.cube->get_sample_report();
+        EXPECT_EQ(sampled.C, g.golden) << keys;
+        EXPECT_EQ(cycle.C, sampled.C) << keys;
+        EXPECT_FALSE(sampled.mem->has_pending()) << keys;
+        EXPECT_LT(report.tiles_sampled, report.tiles_total / 4);
+        double err = (static_cast<double>(sampled.cycles()) - static_cast<double>(cycle.cycles())) /
+                     static_cast<double>(cycle.cycles());
+        EXPECT_LT(std::abs(err), 0.02) << keys;
+    }
+}
+
+// tile 时序缓存：重放结果（周期与累加器内容）需与完整仿真一致；
+// verify 模式下命中的 tile 仍被仿真并比对，不应出现不一致。
+// A 稀疏且各 tile 零元个数不同：命中的 tile 按自身数据统计 MAC，而非沿用记录值。
+TEST_F(Integration, TileCacheReplayMatchesFullSimulation) {
+    Gemm g = random_gemm(70, 50, 60);
+    for (size_t i = 0; i < g.A.size(); i += 7) g.A[i] = 0;
+    const char *cache_keys[3] = {"", "tile_cache = true\n", "tile_cache = true\ntile_cache_verify = true\n"};
+    CubeRun runs[3];
+    for (int r = 0; r < 3; ++r) {
+        use_config("tile_cache_cfg.toml", std::string("[cube]\narray_rows = 8\narray_cols = 8\n") + cache_keys[r] +
+                                              "[memory]\nmemory_latency = 20\nbandwidth = 4\n");
+        runs[r] = run_cube(g);
+        ASSERT_TRUE(runs[r].ok);
+    }
+    const SystolicArray::Stats &s0 = runs[0].stats();
+    for (int r = 1; r < 3; ++r) {
+        const SystolicArray::Stats &s = runs[r].stats();
+        EXPECT_EQ(runs[r].C, runs[0].C);
+        EXPECT_EQ(runs[r].cycles(), runs[0].cycles());
+        EXPECT_EQ(s.compute_cycles, s0.compute_cycles);
+        EXPECT_EQ(s.load_cycles, s0.load_cycles);
+        EXPECT_EQ(s.memory_backpressure_cycles, s0.memory_backpressure_cycles);
+        EXPECT_EQ(s.mac_operations, s0.mac_operations);
+        // 9 x 7 x 8 tiles, at most 8 distinct shapes
+        EXPECT_EQ(s.tile_cache_hits + s.tile_cache_misses, 504u);
+        EXPECT_LE(s.tile_cache_misses, 8u);
+    }
+    EXPECT_EQ(runs[2].stats().tile_cache_verify_failures, 0u);
+}
+
+// 目的：验证 2D 跨步描述符读取（cube.prefetch_descriptors）与逐元素读取结果一致、
+// 访存元素数相同，且每个 B 子块一条请求后发射反压周期明显减少。
+TEST_F(Integration, DescriptorReadMatchesPerElementReads) {
+    const Gemm g = random_gemm(37, 53, 41);
+    SystolicArray::Stats s[2];
+    for (int r = 0; r < 2; ++r) {
+        use_config("descriptor_cfg.toml", std::string("[cube]\narray_rows = 12\narray_cols = 20\nprefetch_descriptors = ") +
+                                              (r ? "true" : "false") + "\n[memory]\nmemory_latency = 7\nbandwidth = 3\n");
+        const CubeRun run = run_cube(g);
+        ASSERT_TRUE(run.ok);
+        EXPECT_EQ(run.C, g.golden);
+        s[r] = run.stats();
+    }
+    // Same elements move either way; one request per B sub-block removes
+    // almost all issue backpressure.
+    EXPECT_EQ(s[1].memory_accesses, s[0].memory_accesses);
+    EXPECT_LT(s[1].memory_backpressure_cycles, s[0].memory_backpressure_cycles);
+    EXPECT_LE(s[1].total_cycles, s[0].total_cycles);
+}
+
+// 目的：验证分 bank 内存模型（memory.banked）：A/B 读取分别统计行命中与缺失，
+// 结果与平坦内存一致；行缺失代价越高，总周期越长。
+TEST_F(Integration, BankedMemoryRowLocalityAndConflicts) {
+    const Gemm g = random_gemm(48, 40, 64);
+    // flat, banked with cheap misses, banked with expensive misses
+    const char *mem_keys[3] = {"", "banked = true\nrow_miss_latency = 10\n", "banked = true\nrow_miss_latency = 40\n"};
+    Cycle cycles[3] = {0, 0, 0};
+    SystolicArray::Stats s[3];
+    for (int r = 0; r < 3; ++r) {
+        use_config("banked_cfg.toml", std::string("[cube]\narray_rows = 8\narray_cols = 8\n"
+                                                  "[memory]\nmemory_latency = 10\nbandwidth = 4\nsize_kb = 8192\n"
+                                                  "banks = 4\nbank_interleave = 8\nrow_size = 64\n") + mem_keys[r]);
+        const CubeRun run = run_cube(g);
+        ASSERT_TRUE(run.ok);
+        EXPECT_EQ(run.C, g.golden);
+        cycles[r] = run.cycles();
+        s[r] = run.stats();
+    }
+    EXPECT_EQ(s[0].a_row_hits + s[0].a_row_misses + s[0].b_row_hits + s[0].b_row_misses, 0u);
+    for (int r = 1; r < 3; ++r) {
+        EXPECT_GT(s[r].a_row_hits + s[r].a_row_misses, 0u);
+        EXPECT_GT(s[r].b_row_hits + s[r].b_row_misses, 0u);
+        // B sub-block rows sit N elements apart and keep reopening rows
+        EXPECT_GT(s[r].b_row_misses, 0u);
+    }
+    EXPECT_GT(cycles[2], cycles[1]);
+}
+
+// 目的：验证稀疏分页后备存储支持超出 32 位且相距很远的元素地址：
+// 结果正确，且只有 A、B、C 所在的页常驻（分别覆盖 page_mmap 开 / 关）。
+TEST_F(Integration, PagedMemoryHighScatteredAddresses) {
+    Gemm g = random_gemm(20, 18, 24);
+    // beyond 32-bit element addresses, far apart
+    g.a_addr = (Addr(3) << 32) + 100;
+    g.b_addr = Addr(5) << 32;
+    g.c_addr = (Addr(6) << 32) + 7;
+    for (int use_mmap = 0; use_mmap < 2; ++use_mmap) {
+        use_config("paged_cfg.toml", std::string("[cube]\narray_rows = 8\narray_cols = 8\n"
+                                                 "[memory]\nmemory_latency = 5\nbandwidth = 4\npage_mmap = ") +
+                                         (use_mmap ? "true" : "false") + "\n");
+        const CubeRun run = run_cube(g);
+        ASSERT_TRUE(run.ok);
+        EXPECT_EQ(run.C, g.golden);
+        // only the pages holding A, B and C are resident
+        EXPECT_LE(run.mem->resident_bytes(), 8u * 4096u * sizeof(AccType));
+    }
+}
+
+// 目的：验证用例二进制以写时复制方式映射进 Mem：页对齐的 A 整页映射、未对齐的 B 读入，
+// 结果与参考一致；对映射页的写入只留在本 Mem 中，磁盘文件不变。
+TEST_F(Integration, PagedMemoryMappedCaseBinaries) {
+    const std::string dir = case_dir();
+    const Gemm g = random_gemm(96, 80, 128);
+    const std::string a_bin = dir + "/mapped_A.bin", b_bin = dir + "/mapped_B.bin";
+    ASSERT_TRUE(util::write_bin(a_bin, g.A));
+    ASSERT_TRUE(util::write_bin(b_bin, g.B));
+
+    use_config("mapped_cfg.toml", "[cube]\narray_rows = 16\narray_cols = 16\n[memory]\nmemory_latency = 5\nbandwidth = 4\n");
+    // A on a page boundary (whole pages mapped), B deliberately unaligned (read in)
+    const Addr a_addr = Addr(1) << 20, b_addr = (Addr(2) << 20) + 3, c_addr = 0;
+    auto clk = std::make_shared<Clock>();
+    auto mem = std::make_shared<Mem>(clk);
+    size_t a_elems = 0;
+    ASSERT_TRUE(mem->map_file(a_bin, a_addr, &a_elems));
+    ASSERT_TRUE(mem->map_file(b_bin, b_addr));
+    EXPECT_EQ(a_elems, g.A.size());
+    EXPECT_EQ(mem->mapped_pages(), g.A.size() / 4096);
+    {
+        Cube cube(clk, mem);
+        ASSERT_TRUE(cube.run(g.M, g.N, g.K, a_addr, b_addr, c_addr));
+    }
+    EXPECT_EQ(read_c(mem, g), g.golden);
+
+    // Writes to a mapped page stay private to this Mem.
+    ASSERT_TRUE(mem->write_request(a_addr, static_cast<DataType>(g.A[0] + 1)));
+    for (int i = 0; i < mem->get_latency() + 2; ++i) mem->cycle();
+    DataType v = 0;
+    ASSERT_TRUE(mem->load_direct(a_addr, 1, &v));
+    EXPECT_EQ(v, static_cast<DataType>(g.A[0] + 1));
+    std::vector<DataType> on_disk;
+    ASSERT_TRUE(util::read_bin(a_bin, on_disk));
+    EXPECT_EQ(on_disk, g.A);
+}
+
+// 目的：验证计时写回通道（cube.timed_writeback）：写合并缓冲把一个 tile 的连续结果行
+// 合并成 burst，结果与不计时写回一致；串行排空（drain_overlap = false）比重叠排空更慢。
+TEST_F(Integration, WritebackTimedDrainWithWriteCombining) {
+    const Gemm g = random_gemm(40, 8, 24);
+
+    // untimed, timed + overlapped drain, timed + serialized drain
+    const char *keys[3] = {"", "timed_writeback = true\n", "timed_writeback = true\ndrain_overlap = false\n"};
+    SystolicArray::Stats s[3];
+    for (int r = 0; r < 3; ++r) {
+        use_config("writeback_cfg.toml", std::string("[cube]\narray_rows = 8\narray_cols = 8\nwcb_entries = 2\nwcb_burst = 32\n") +
+                                             keys[r] + "[memory]\nmemory_latency = 30\nbandwidth = 2\n");
+        const CubeRun run = run_cube(g);
+        ASSERT_TRUE(run.ok);
+        EXPECT_FALSE(run.mem->has_pending());
+        EXPECT_EQ(run.C, g.golden);
+        s[r] = run.stats();
+    }
+    EXPECT_EQ(s[0].drain_cycles, 0u);
+    EXPECT_EQ(s[0].writeback_bursts, 0u);
+    // N == n_tile: the 8 rows of a tile are contiguous and merge into 32-element bursts
+    const uint64_t tiles = (g.M / 8) * ((g.K + 7) / 8);
+    EXPECT_EQ(s[1].writeback_bursts, tiles * 2);
+    EXPECT_EQ(s[2].writeback_bursts, tiles * 2);
+    EXPECT_GT(s[2].drain_cycles, s[1].drain_cycles);
+    EXPECT_GT(s[1].total_cycles, s[0].total_cycles);
+    EXPECT_GT(s[2].total_cycles, s[1].total_cycles);
+}
+
+// 目的：验证片上本地缓冲（buffer.enabled）的 A/B tile 复用：命中 / 缺失数与省下的主存读
+// 元素数符合 tile 复用次数，总周期下降；同容量下显式分配优于 LRU（LRU 在行面板间抖动）。
+TEST_F(Integration, LocalBufferTileReuseSkipsMemory) {
+    const Gemm g = random_gemm(24, 24, 16);
+
+    // no buffer, LRU with room for everything, explicit allocation with room
+    // for one A row panel (2 tiles) plus all of B (6 tiles) = 1 KiB
+    const char *keys[4] = {"", "enabled = true\n", "enabled = true\ncapacity_kb = 1\npolicy = \"EXPLICIT\"\n",
+                           "enabled = true\ncapacity_kb = 1\n"};
+    SystolicArray::Stats s[4];
+    for (int r = 0; r < 4; ++r) {
+        use_config("buffer_cfg.toml", std::string("[cube]\narray_rows = 8\narray_cols = 8\n"
+                                                  "[memory]\nmemory_latency = 30\nbandwidth = 4\n[buffer]\n") + keys[r]);
+        const CubeRun run = run_cube(g);
+        ASSERT_TRUE(run.ok);
+        EXPECT_EQ(run.C, g.golden);
+        s[r] = run.stats();
+    }
+    EXPECT_EQ(s[0].buffer_hits + s[0].buffer_misses, 0u);
+    // 18 tiles, one A and one B lookup each; 6 distinct A and 6 distinct B tiles
+    for (int r = 1; r <= 2; ++r) {
+        EXPECT_EQ(s[r].buffer_misses, 12u);
+        EXPECT_EQ(s[r].buffer_hits, 24u);
+        EXPECT_EQ(s[r].buffer_saved_elems, 24u * 64u);
+        EXPECT_EQ(s[r].memory_accesses + s[r].buffer_saved_elems, s[0].memory_accesses);
+        EXPECT_LT(s[r].total_cycles, s[0].total_cycles);
+    }
+    // LRU at the same capacity thrashes on B between row panels
+    EXPECT_LT(s[3].buffer_hits, s[2].buffer_hits);
+}
+
+// 目的：验证多通道异步 DMA 引擎：按行 / 按列分发到各 FIFO 流的数据正确，
+// 通道队列满时拒收新描述符，低编号通道优先发射，完成事件按序上报，并统计等待 Mem 的周期。
+TEST_F(Integration, DmaEngineChannelsQueueAndComplete) {
+    use_config("dma_cfg.toml", "[memory]\nmemory_latency = 6\nbandwidth = 1\nmax_outstanding = 2\n");
+    auto clk = std::make_shared<Clock>();
+    auto mem = std::make_shared<Mem>(clk);
+    std::vector<DataType> data(64);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = static_cast<DataType>(i + 1);
+    mem->pv_write(reinterpret_cast<uint64_t>(data.data()), data.size(), 0);
+
+    DmaEngine dma(mem, 2, 1);
+    clk->add_listener([&]() { mem->cycle(); dma.cycle(); });
+    std::vector<FIFO> rows(3, FIFO(8)), cols(4, FIFO(8));
+    std::vector<int> row_ids, col_ids;
+    for (auto &f : rows) row_ids.push_back(mem->register_stream(&f));
+    for (auto &f : cols) col_ids.push_back(mem->register_stream(&f));
+    std::vector<DmaEngine::Completion> events;
+    dma.set_completion_handler([&](const DmaEngine::Completion &c) { events.push_back(c); });
+
+    // 3 rows of 5 from a row stride of 8, one request per row, into rows[r]
+    DmaEngine::Descriptor a;
+    a.src = 0; a.count = 5; a.stride = 8; a.repeat = 3;
+    a.stream = row_ids[0]; a.stream_row_step = 1; a.burst = 5;
+    // 2 x 4 block at 32 as one 2D request, column c into cols[c]
+    DmaEngine::Descriptor b;
+    b.src = 32; b.count = 4; b.stride = 8; b.repeat = 2;
+    b.stream = col_ids[0]; b.stream_col_step = 1;
+    const uint32_t ia = dma.submit(0, a);
+    const uint32_t ib = dma.submit(1, b);
+    ASSERT_NE(ia, 0u);
+    ASSERT_NE(ib, 0u);
+    EXPECT_EQ(dma.submit(0, a), 0u); // queue depth 1
+    EXPECT_FALSE(dma.idle());
+
+    for (int t = 0; t < 200 && !dma.idle(); ++t) clk->tick();
+    ASSERT_TRUE(dma.idle());
+    ASSERT_EQ(events.size(), 2u);
+    EXPECT_EQ(events[0].id, ia);   // channel 0 has priority for the issue slots
+    EXPECT_EQ(events[1].id, ib);
+    EXPECT_EQ(events[1].channel, 1);
+    EXPECT_EQ(events[1].elements, 8u);
+    // 1 read issue per cycle and 2 outstanding: the engine waited on Mem
+    EXPECT_GT(dma.stall_cycles(), 0u);
+    EXPECT_EQ(dma.channel_stats(0).requests, 3u);
+    EXPECT_EQ(dma.channel_stats(1).requests, 1u);
+
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 5; ++c) {
+            DataType v = 0;
+            ASSERT_TRUE(rows[static_cast<size_t>(r)].pop(v));
+            EXPECT_EQ(v, data[static_cast<size_t>(r * 8 + c)]);
+        }
+    }
+    for (int r = 0; r < 2; ++r) {
+        for (int c = 0; c < 4; ++c) {
+            DataType v = 0;
+            ASSERT_TRUE(cols[static_cast<size_t>(c)].pop(v));
+            EXPECT_EQ(v, data[static_cast<size_t>(32 + r * 8 + c)]);
+        }
+    }
+}
+
+// 目的：验证访存轨迹的紧凑二进制记录与重放：同一内存配置下每个请求都在记录的周期发射，
+// 更窄的内存上请求被拒收并落后于记录（slip），重放总周期变长。
+TEST_F(Integration, MemTraceRecordAndReplay) {
+    const std::string trace = case_dir() + "/gemm.xtrc";
+    const Gemm g = random_gemm(32, 40, 24);
+    auto trace_config = [](const std::string &mem_keys) {
+        use_config("trace_cfg.toml", "[cube]\narray_rows = 8\narray_cols = 8\ntimed_writeback = true\n"
+                                     "[memory]\nmemory_latency = 20\n" + mem_keys);
+    };
+
+    trace_config("bandwidth = 4\n");
+    uint64_t records = 0, bytes = 0, mem_cycles = 0;
+    {
+        auto clk = std::make_shared<Clock>();
+        auto mem = load_mem(clk, g);
+        ASSERT_TRUE(mem->start_trace(trace));
+        Cube cube(clk, mem);
+        const Cycle t0 = mem->now();
+        ASSERT_TRUE(cube.run(g.M, g.N, g.K, g.a_addr, g.b_addr, g.c_addr));
+        mem_cycles = mem->now() - t0;
+        records = mem->trace()->records();
+        bytes = mem->trace()->bytes();
+        mem->stop_trace();
+    }
+    ASSERT_GT(records, 0u);
+    EXPECT_LT(bytes, records * 6 + 8); // delta + varint encoding
+
+    // Same memory: every request issues at its recorded cycle.
+    MemReplayStats same{};
+    {
+        Mem mem;
+        ASSERT_TRUE(replay_mem_trace(trace, mem, same));
+    }
+    EXPECT_EQ(same.records, records);
+    EXPECT_EQ(same.slip_cycles, 0u);
+    EXPECT_EQ(same.rejected_cycles, 0u);
+    EXPECT_LE(same.cycles, mem_cycles);
+    EXPECT_GE(same.mean_read_latency, 20.0);
+
+    // Narrower memory: requests are refused and slip behind the recording.
+    trace_config("bandwidth = 1\nmax_outstanding = 4\n");
+    MemReplayStats narrow{};
+    {
+        Mem mem;
+        ASSERT_TRUE(replay_mem_trace(trace, mem, narrow));
+    }
+    EXPECT_EQ(narrow.records, records);
+    EXPECT_GT(narrow.slip_cycles, 0u);
+    EXPECT_GT(narrow.rejected_cycles, 0u);
+    EXPECT_GT(narrow.cycles, same.cycles);
+}
+
+// 目的：验证 Mem 自动合并相邻的逐元素读请求（memory.coalesce）：结果与访存元素数不变，
+// 被合并的读不占发射带宽与未完成窗口，反压周期与总周期下降。
+TEST_F(Integration, CoalesceMergesPerElementReads) {
+    const Gemm g = random_gemm(29, 44, 36);
+
+    SystolicArray::Stats s[2];
+    Mem::CoalesceStats cs[2];
+    for (int r = 0; r < 2; ++r) {
+        use_config("coalesce_cfg.toml", std::string("[cube]\narray_rows = 8\narray_cols = 12\nprefetch_descriptors = false\n"
+                                                    "[memory]\nmemory_latency = 12\nbandwidth = 2\nmax_outstanding = 16\n"
+                                                    "coalesce = ") +
+                                            (r ? "true" : "false") + "\ncoalesce_window = 6\n");
+        const CubeRun run = run_cube(g);
+        ASSERT_TRUE(run.ok);
+        EXPECT_EQ(run.C, g.golden);
+        s[r] = run.stats();
+        cs[r] = run.mem->get_coalesce_stats();
+    }
+    EXPECT_EQ(cs[0].merged_reads, 0u);
+    EXPECT_GT(cs[1].merged_reads, 0u);
+    EXPECT_GT(cs[1].bursts, 0u);
+    EXPECT_LE(cs[1].peak_pending, 16u);
+    // merged reads take neither issue slots nor outstanding entries
+    EXPECT_EQ(s[1].memory_accesses, s[0].memory_accesses);
+    EXPECT_LT(s[1].memory_backpressure_cycles, s[0].memory_backpressure_cycles);
+    EXPECT_LT(s[1].total_cycles, s[0].total_cycles);
+}
+
+// 预取前瞻：后续 tile 的加载与当前 tile 的计算重叠，结果不变、总周期下降；
+// 加载在途时保存的检查点恢复后与一次性运行一致。
+TEST_F(Integration, LookaheadOverlapsLoadsWithCompute) {
+    const Gemm g = random_gemm(40, 40, 40);
+    auto lookahead_config = [](int depth) {
+        use_config("lookahead_cfg.toml", "[cube]\narray_rows = 8\narray_cols = 8\nprefetch_depth = " + std::to_string(depth) +
+                                             "\n[memory]\nmemory_latency = 10\nbandwidth = 4\n");
+    };
+
+    SystolicArray::Stats s[2];
+    Cycle cycles[2] = {0, 0};
+    for (int r = 0; r < 2; ++r) {
+        lookahead_config(r ? 2 : 0);
+        const CubeRun run = run_cube(g);
+        ASSERT_TRUE(run.ok);
+        EXPECT_EQ(run.C, g.golden);
+        s[r] = run.stats();
+        cycles[r] = run.cycles();
+    }
+    EXPECT_EQ(s[0].prefetch_overlap_cycles, 0u);
+    EXPECT_EQ(s[1].compute_cycles, s[0].compute_cycles);
+    EXPECT_EQ(s[1].memory_accesses, s[0].memory_accesses);
+    EXPECT_GT(s[1].prefetch_overlap_cycles, s[1].compute_cycles / 2);
+    EXPECT_GT(s[1].prefetch_ready_tiles, 100u);
+    EXPECT_LT(s[1].load_cycles * 4, s[0].load_cycles);
+    EXPECT_LT(s[1].total_cycles * 3, s[0].total_cycles * 2);
+
+    // checkpoint taken with the next tiles' loads in flight
+    const std::string snap = case_dir() + std::string("/lookahead.snap");
+    {
+        auto clk = std::make_shared<Clock>();
+        auto mem = load_mem(clk, g);
+        Cube cube(clk, mem);
+        ASSERT_TRUE(cube.start_run(g.M, g.N, g.K, g.a_addr, g.b_addr, g.c_addr));
+        ASSERT_TRUE(cube.resume(7));
+        ASSERT_TRUE(mem->has_pending());
+        ASSERT_TRUE(cube.save_checkpoint(snap));
+    }
+    {
+        auto clk = std::make_shared<Clock>();
+        auto mem = std::make_shared<Mem>(clk);
+        Cube cube(clk, mem);
+        ASSERT_TRUE(cube.load_checkpoint(snap));
+        ASSERT_TRUE(cube.resume());
+        EXPECT_EQ(clk->now(), cycles[1]);
+        EXPECT_EQ(read_c(mem, g), g.golden);
+    }
+}
+
+// 目的：验证 tile 调度：循环顺序与 tile 尺寸只改变调度、不改变结果，周期与解析模型一致；
+// K 累加（cube.k_accumulate）下每个输出 tile 只付一次填充 / 排空开销，
+// 且在同一输出 tile 的两个 K 块之间保存的检查点恢复后与一次性运行一致。
+TEST_F(Integration, TilingLoopOrderAndKAccumulation) {
+    const Gemm g = random_gemm(40, 40, 64);
+    auto tiling_config = [](const std::string &cube_keys) {
+        use_config("tiling_cfg.toml", "[cube]\narray_rows = 8\narray_cols = 8\n" + cube_keys +
+                                          "[memory]\nmemory_latency = 10\nbandwidth = 4\n");
+    };
+
+    const std::string keys[3] = {"", "loop_order = \"KNM\"\ntile_rows = 6\ntile_cols = 5\ntile_k = 12\n",
+                                 "k_accumulate = true\n"};
+    SystolicArray::Stats s[3];
+    for (int r = 0; r < 3; ++r) {
+        tiling_config(keys[r]);
+        auto clk = std::make_shared<Clock>();
+        auto mem = load_mem(clk, g);
+        SystolicArray sa(clk, mem);
+        ASSERT_TRUE(sa.run(g.M, g.N, g.K, g.a_addr, g.b_addr, g.c_addr));
+        EXPECT_EQ(read_c(mem, g), g.golden) << keys[r];
+        s[r] = sa.get_stats();
+        const PerfEstimate e = estimate_gemm(sa.perf_model_params(), g.M, g.N, g.K);
+        EXPECT_EQ(s[r].total_cycles, e.total_cycles) << keys[r];
+        EXPECT_EQ(s[r].compute_cycles, e.compute_cycles) << keys[r];
+    }
+    // 25 output tiles of 8 K chunks: seven fill / drain / latency tails saved each
+    EXPECT_EQ(s[2].compute_cycles + 25u * 7u * (8u + 8u + 10u), s[0].compute_cycles);
+    EXPECT_EQ(s[2].memory_accesses, s[0].memory_accesses);
+
+    // checkpoint taken between two K chunks of an output tile, with the
+    // partial sums in the PE accumulators
+    tiling_config("k_accumulate = true\nprefetch_depth = 1\n");
+    const std::string snap = case_dir() + std::string("/tiling.snap");
+    const CubeRun full = run_cube(g);
+    ASSERT_TRUE(full.ok);
+    {
+        auto clk = std::make_shared<Clock>();
+        auto mem = load_mem(clk, g);
+        Cube cube(clk, mem);
+        ASSERT_TRUE(cube.start_run(g.M, g.N, g.K, g.a_addr, g.b_addr, g.c_addr));
+        ASSERT_TRUE(cube.resume(11));
+        ASSERT_TRUE(cube.save_checkpoint(snap));
+    }
+    {
+        auto clk = std::make_shared<Clock>();
+        auto mem = std::make_shared<Mem>(clk);
+        Cube cube(clk, mem);
+        ASSERT_TRUE(cube.load_checkpoint(snap));
+        ASSERT_TRUE(cube.resume());
+        EXPECT_EQ(clk->now(), full.cycles());
+        EXPECT_EQ(read_c(mem, g), g.golden);
+    }
+}
+
+// 目的：验证批量 GEMM（按注意力头计算分数，每个操作数都是跨步切片）：无前瞻时批量的
+// 周期数与逐个运行之和完全相同；有前瞻时下一个 GEMM 的加载与当前 GEMM 的计算重叠，总周期下降。
+// 解析与功能模式也接受同一组描述符。
+TEST_F(Integration, BatchBackToBackWithCrossGemmPrefetch) {
+    const int H = 6, S = 20, D = 12;
+    // A: S x (H*D) row-major; B: (H*D) x S; C: S x (H*S), head h at column h*S
+    Gemm g;
+    g.M = S;
+    g.N = H * S;
+    g.K = H * D;
+    g.A = util::generate_random_matrix(S, H * D);
+    g.B = util::generate_random_matrix(H * D, S);
+    g.b_addr = static_cast<Addr>(g.A.size());
+    g.golden.resize(static_cast<size_t>(S) * H * S);
+    std::vector<GemmDesc> gemms;
+    for (int h = 0; h < H; ++h) {
+        gemms.push_back(GemmDesc{S, S, D, g.a_addr + static_cast<Addr>(h * D), g.b_addr + static_cast<Addr>(h * D * S),
+                                 g.c_addr + static_cast<Addr>(h * S), H * D, S, H * S});
+        std::vector<DataType> a(static_cast<size_t>(S) * D), b(g.B.begin() + h * D * S, g.B.begin() + (h + 1) * D * S);
+        for (int i = 0; i < S; ++i)
+            for (int k = 0; k < D; ++k) a[static_cast<size_t>(i) * D + k] = g.A[static_cast<size_t>(i) * H * D + h * D + k];
+        auto c = util::compute_reference(a, S, D, b, S);
+        for (int i = 0; i < S; ++i)
+            for (int j = 0; j < S; ++j) g.golden[static_cast<size_t>(i) * H * S + h * S + j] = c[static_cast<size_t>(i) * S + j];
+    }
+    auto batch_config = [](int depth) {
+        use_config("batch_cfg.toml", "[cube]\narray_rows = 8\narray_cols = 8\nprefetch_depth = " + std::to_string(depth) +
+                                         "\n[memory]\nmemory_latency = 10\nbandwidth = 4\n");
+    };
+
+    uint64_t batch_cycles[2] = {0, 0}, separate_cycles[2] = {0, 0};
+    for (int r = 0; r < 2; ++r) {
+        batch_config(r ? 2 : 0);
+        {
+            auto clk = std::make_shared<Clock>();
+            auto mem = load_mem(clk, g);
+            Cube cube(clk, mem);
+            ASSERT_TRUE(cube.run_batch(gemms));
+            EXPECT_EQ(read_c(mem, g), g.golden);
+            const SystolicArray::Stats &total = cube.get_stats();
+            ASSERT_EQ(cube.get_gemm_stats().size(), gemms.size());
+            uint64_t cycles = 0, macs = 0, accesses = 0;
+            for (const auto &gs : cube.get_gemm_stats()) {
+                EXPECT_GT(gs.total_cycles, 0u);
+                cycles += gs.total_cycles;
+                macs += gs.mac_operations;
+                accesses += gs.memory_accesses;
+            }
+            EXPECT_EQ(cycles, total.total_cycles);
+            EXPECT_EQ(macs, total.mac_operations);
+            EXPECT_EQ(accesses, total.memory_accesses);
+            EXPECT_EQ(total.total_cycles, clk->now());
+            batch_cycles[r] = total.total_cycles;
+        }
+        {
+            auto clk = std::make_shared<Clock>();
+            auto mem = load_mem(clk, g);
+            SystolicArray sa(clk, mem);
+            for (const GemmDesc &d : gemms) {
+                ASSERT_TRUE(sa.run_batch({d}));
+                separate_cycles[r] += sa.get_stats().total_cycles;
+            }
+            EXPECT_EQ(read_c(mem, g), g.golden);
+        }
+    }
+    EXPECT_EQ(batch_cycles[0], separate_cycles[0]);
+    EXPECT_LT(batch_cycles[1], separate_cycles[1]);
+    EXPECT_LT(batch_cycles[1] * 3, batch_cycles[0] * 2);
+
+    // the closed-form and functional paths take the same descriptors
+    batch_config(0);
+    {
+        auto clk = std::make_shared<Clock>();
+        auto mem = load_mem(clk, g);
+        Cube cube(clk, mem);
+        cube.set_fidelity(Fidelity::ANALYTICAL);
+        ASSERT_TRUE(cube.run_batch(gemms));
+        EXPECT_EQ(cube.get_stats().total_cycles, batch_cycles[0]);
+        EXPECT_EQ(cube.get_gemm_stats().size(), gemms.size());
+        cube.set_fidelity(Fidelity::FUNCTIONAL);
+        ASSERT_TRUE(cube.run_batch(gemms));
+        EXPECT_EQ(read_c(mem, g), g.golden);
+    }
+}
+
+// 目的：验证多 cube 共享时钟与内存：按 M 或 N 切分后结果与参考一致；各 cube 的
+// 内存争用周期随 cube 数增加，且事件驱动时钟与逐周期 tick 的周期数一致。
+TEST_F(Integration, MultiCubeSharedMemoryContention) {
+    const std::string dir = case_dir();
+    const Gemm g = random_gemm(64, 48, 32);
+    const std::string case_toml = dir + std::string("/case_MultiCube.toml");
+    util::CaseConfig case_cfg;
+    ASSERT_TRUE(util::create_case_toml(case_toml, case_cfg, dir, std::string("MultiCube"), g.A, g.B, g.M, g.K, g.N));
+
+    auto run = [&](int cubes, const char *partition, bool event_driven, uint64_t &contention) {
+        use_config("multi_cube_cfg.toml", "[cube]\narray_rows = 8\narray_cols = 8\nprefetch_depth = 1\n"
+                                          "[memory]\nmemory_latency = 20\nbandwidth = 8\nmax_outstanding = 16\n"
+                                          "[aic]\ncubes = " + std::to_string(cubes) + "\npartition = \"" + partition + "\"\n");
+        auto clk = std::make_shared<Clock>();
+        clk->set_event_driven(event_driven);
+        auto mem = std::make_shared<Mem>(clk);
+        AIC aic(clk, mem);
+        aic.build(case_toml);
+        EXPECT_TRUE(aic.start());
+        EXPECT_EQ(aic.get_cube_reports().size(), static_cast<size_t>(cubes));
+        contention = 0;
+        for (const auto &r : aic.get_cube_reports()) {
+            EXPECT_GT(r.cycles, 0u);
+            EXPECT_LE(r.cycles, clk->now());
+            EXPECT_GT(r.utilization, 0.0);
+            contention += r.contention_cycles;
+        }
+        return clk->now();
+    };
+
+    uint64_t contention[3];
+    const uint64_t one = run(1, "M", false, contention[0]);
+    const uint64_t two = run(2, "M", false, contention[1]);
+    const uint64_t four = run(4, "M", false, contention[2]);
+    EXPECT_LT(two, one);
+    EXPECT_LT(four, two);
+    // four cubes saturate the shared bandwidth: well short of a 4x speedup
+    EXPECT_GT(four * 3, one);
+    EXPECT_LT(contention[0], contention[1]);
+    EXPECT_LT(contention[1], contention[2]);
+
+    uint64_t c_tick = 0, c_event = 0;
+    EXPECT_EQ(run(3, "N", false, c_tick), run(3, "N", true, c_event));
+    EXPECT_EQ(c_tick, c_event);
+}
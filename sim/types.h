@@ -13,6 +13,7 @@ class SystolicArray;
 typedef int16_t DataType;      // 16位定点数
 typedef int32_t AccType;       // 32位累加器
 typedef uint64_t Cycle;        // 周期计数器
+typedef uint64_t Addr;         // 模拟内存地址（按元素索引）
 
 enum class Dataflow {
     WEIGHT_STATIONARY,
@@ -20,6 +21,37 @@ enum class Dataflow {
     INPUT_STATIONARY
 };
 
+// 仿真精度：CYCLE 逐周期仿真；ANALYTICAL 用闭式模型估计周期（不计算数据）；
+// FUNCTIONAL 只计算数值结果（宿主 GEMM），不建模时序；SAMPLED 抽样逐周期仿真部分 tile 并外推
+enum class Fidelity {
+    CYCLE,
+    ANALYTICAL,
+    FUNCTIONAL,
+    SAMPLED
+};
+
+// 本地缓冲（buffer.policy）的分配方式：LRU 替换，或 EXPLICIT 显式分配（不驱逐）
+enum class BufferPolicy {
+    LRU,
+    EXPLICIT
+};
+
+// tile 循环顺序（cube.loop_order）：从外到内的三层循环，如 MNK 为 mb → nb → kb
+enum class LoopOrder {
+    MNK,
+    MKN,
+    NMK,
+    NKM,
+    KMN,
+    KNM
+};
+
+// 多 cube 时 GEMM 的切分维度（aic.partition）：按 M 行块或 N 列块分给各 cube
+enum class CubePartition {
+    M,
+    N
+};
+
 // Common pointer aliases
 using p_clock_t = std::shared_ptr<Clock>;
 using p_mem_t = std::shared_ptr<Mem>;
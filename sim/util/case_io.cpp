@@ -117,8 +117,8 @@ bool create_cube_case_config(const std::string &case_toml, CaseConfig &cfg,
     cfg.c_golden_path = case_dir + std::string("/") + base_name + std::string("_C_golden.bin");
     cfg.c_out_path = case_dir + std::string("/") + base_name + std::string("_C_out.bin");
     cfg.a_addr = 0;
-    cfg.b_addr = static_cast<uint32_t>(A.size());
-    cfg.c_addr = static_cast<uint32_t>(A.size() + B.size());
+    cfg.b_addr = static_cast<uint64_t>(A.size());
+    cfg.c_addr = static_cast<uint64_t>(A.size() + B.size());
     cfg.M = M; cfg.K = K; cfg.N = N;
     // 默认引用共享的 model_cfg.toml（相对路径）
     cfg.model_cfg_path = std::string("model_cfg.toml");
@@ -207,9 +207,9 @@ bool CaseConfig::from_map(const config::TomlParser::map_t &m, const std::string
     } catch(...) {
         // 若解析失败则保留原始值
     }
-    auto sa = get("input.a.addr"); if (!sa.empty()) out.a_addr = static_cast<uint32_t>(std::stoul(sa));
-    auto sb = get("input.b.addr"); if (!sb.empty()) out.b_addr = static_cast<uint32_t>(std::stoul(sb));
-    auto sc = get("output.c.addr"); if (!sc.empty()) out.c_addr = static_cast<uint32_t>(std::stoul(sc));
+    auto sa = get("input.a.addr"); if (!sa.empty()) out.a_addr = static_cast<uint64_t>(std::stoull(sa));
+    auto sb = get("input.b.addr"); if (!sb.empty()) out.b_addr = static_cast<uint64_t>(std::stoull(sb));
+    auto sc = get("output.c.addr"); if (!sc.empty()) out.c_addr = static_cast<uint64_t>(std::stoull(sc));
     auto ta = get("input.a.type"); if (!ta.empty()) out.a_type = ta;
     auto tb = get("input.b.type"); if (!tb.empty()) out.b_type = tb;
     auto tc = get("output.c.type"); if (!tc.empty()) out.c_type = tc;
@@ -11,11 +11,11 @@ namespace util {
 struct CaseConfig {
     std::string case_path; // case TOML 文件路径
     std::string a_path;    // A 矩阵二进制路径
-    uint32_t a_addr = 0;   // A 的内存地址偏移
+    uint64_t a_addr = 0;   // A 的内存地址偏移
     std::string b_path;    // B 矩阵二进制路径
-    uint32_t b_addr = 0;   // B 的内存地址偏移
+    uint64_t b_addr = 0;   // B 的内存地址偏移
     std::string c_golden_path; // 参考（golden）C 矩阵文件
-    uint32_t c_addr = 0;   // C 的内存地址偏移
+    uint64_t c_addr = 0;   // C 的内存地址偏移
     std::string c_out_path; // 运行时输出文件（可选）
     // 引用的 model_cfg.toml 路径（相对或绝对）
     std::string model_cfg_path;
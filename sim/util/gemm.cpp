@@ -0,0 +1,129 @@
+#include "util/gemm.h"
+#include "util/worker_pool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// 文件：util/gemm.cpp
+// 说明：分块 GEMM 实现。每个分片负责 C 的一个 kMc × kNc 块，按 kKc 沿 K 累加；
+// 分片之间写入互不重叠，结果与分片调度顺序无关。
+namespace util {
+
+namespace {
+
+constexpr int kMc = 64;   // rows of C per part
+constexpr int kNc = 256;  // columns of C per part
+constexpr int kKc = 256;  // depth of one packed B panel (even)
+constexpr int kNr = 16;   // columns per micro-kernel step
+
+// Pack B[k0 .. k0+kc) x [j0 .. j0+nc) as 16-column strips of k pairs: each
+// 32-bit word holds (B[k][j], B[k+1][j]) so one madd covers two k steps.
+// Missing rows/columns are zero so the kernel never needs an edge case.
+void pack_b(const int16_t *B, int ldb, int k0, int kc, int j0, int nc, std::vector<int16_t> &out) {
+    const int pairs = (kc + 1) / 2;
+    const int strips = (nc + kNr - 1) / kNr;
+    out.assign(static_cast<size_t>(strips) * pairs * kNr * 2, 0);
+    for (int s = 0; s < strips; ++s) {
+        int16_t *dst = &out[static_cast<size_t>(s) * pairs * kNr * 2];
+        const int jn = std::min(kNr, nc - s * kNr);
+        for (int p = 0; p < pairs; ++p) {
+            for (int h = 0; h < 2; ++h) {
+                int k = 2 * p + h;
+                if (k >= kc) break;
+                const int16_t *src = B + static_cast<size_t>(k0 + k) * ldb + j0 + s * kNr;
+                for (int j = 0; j < jn; ++j) dst[(p * kNr + j) * 2 + h] = src[j];
+            }
+        }
+    }
+}
+
+// c[0..kNr) += sum_k a[k] * panel(strip) over `pairs` k pairs, wrapping mod 2^32.
+inline void micro_kernel(const int16_t *a, int kc, const int16_t *strip, int pairs, uint32_t *c) {
+    int p = 0;
+#if defined(__AVX2__)
+    __m256i acc0 = _mm256_setzero_si256();
+    __m256i acc1 = _mm256_setzero_si256();
+    for (; p < pairs; ++p) {
+        uint16_t lo = static_cast<uint16_t>(a[2 * p]);
+        uint16_t hi = (2 * p + 1 < kc) ? static_cast<uint16_t>(a[2 * p + 1]) : 0;
+        __m256i av = _mm256_set1_epi32(static_cast<int>(static_cast<uint32_t>(lo) | (static_cast<uint32_t>(hi) << 16)));
+        const int16_t *b = strip + static_cast<size_t>(p) * kNr * 2;
+        acc0 = _mm256_add_epi32(acc0, _mm256_madd_epi16(av, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b))));
+        acc1 = _mm256_add_epi32(acc1, _mm256_madd_epi16(av, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + 16))));
+    }
+    __m256i c0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c));
+    __m256i c1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c + 8));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(c), _mm256_add_epi32(c0, acc0));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(c + 8), _mm256_add_epi32(c1, acc1));
+#else
+    // Unsigned accumulation keeps the wrap-around well defined; the fixed
+    // kNr-wide inner loop is left to the compiler's auto-vectorizer.
+    uint32_t acc[kNr] = {0};
+    for (; p < pairs; ++p) {
+        int32_t a0 = a[2 * p];
+        int32_t a1 = (2 * p + 1 < kc) ? a[2 * p + 1] : 0;
+        const int16_t *b = strip + static_cast<size_t>(p) * kNr * 2;
+        for (int j = 0; j < kNr; ++j) {
+            acc[j] += static_cast<uint32_t>(a0 * b[2 * j]) + static_cast<uint32_t>(a1 * b[2 * j + 1]);
+        }
+    }
+    for (int j = 0; j < kNr; ++j) c[j] += acc[j];
+#endif
+}
+
+} // namespace
+
+void gemm_i16_i32(int M, int N, int K,
+                  const int16_t *A, int lda,
+                  const int16_t *B, int ldb,
+                  int32_t *C, int ldc,
+                  WorkerPool *pool) {
+    if (M <= 0 || N <= 0) return;
+    const int row_blocks = (M + kMc - 1) / kMc;
+    const int col_blocks = (N + kNc - 1) / kNc;
+
+    auto part = [&](int idx) {
+        const int i0 = (idx / col_blocks) * kMc;
+        const int j0 = (idx % col_blocks) * kNc;
+        const int mc = std::min(kMc, M - i0);
+        const int nc = std::min(kNc, N - j0);
+        const int strips = (nc + kNr - 1) / kNr;
+        // Row-padded accumulator block; only the first nc columns are stored.
+        std::vector<uint32_t> acc(static_cast<size_t>(mc) * strips * kNr, 0);
+        std::vector<int16_t> panel;
+        for (int k0 = 0; k0 < K; k0 += kKc) {
+            const int kc = std::min(kKc, K - k0);
+            const int pairs = (kc + 1) / 2;
+            pack_b(B, ldb, k0, kc, j0, nc, panel);
+            for (int i = 0; i < mc; ++i) {
+                const int16_t *a = A + static_cast<size_t>(i0 + i) * lda + k0;
+                uint32_t *c = &acc[static_cast<size_t>(i) * strips * kNr];
+                for (int s = 0; s < strips; ++s) {
+                    micro_kernel(a, kc, &panel[static_cast<size_t>(s) * pairs * kNr * 2], pairs, c + s * kNr);
+                }
+            }
+        }
+        for (int i = 0; i < mc; ++i) {
+            std::memcpy(C + static_cast<size_t>(i0 + i) * ldc + j0,
+                        &acc[static_cast<size_t>(i) * strips * kNr], static_cast<size_t>(nc) * sizeof(int32_t));
+        }
+    };
+
+    const int parts = row_blocks * col_blocks;
+    if (pool && pool->size() > 1 && parts > 1) {
+        // WorkerPool tickets carry a 16-bit part count; submit in batches.
+        constexpr int kMaxParts = 4096;
+        for (int base = 0; base < parts; base += kMaxParts) {
+            pool->run(std::min(kMaxParts, parts - base), [&](int p) { part(base + p); });
+        }
+    } else {
+        for (int p = 0; p < parts; ++p) part(p);
+    }
+}
+
+} // namespace util
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+
+// 文件：util/gemm.h
+// 说明：功能模式（Fidelity::FUNCTIONAL）使用的宿主端 int16→int32 GEMM。
+// 按缓存分块（行块 × 列块 × K 块），B 面板打包后做向量化内核（AVX2 下用
+// madd_epi16 每次处理两个 k），行块/列块分片交给 WorkerPool 并行。
+// 累加按 32 位补码回绕，与 PE 累加器和 store_acc_direct 的结果逐位一致。
+namespace util {
+
+class WorkerPool;
+
+// C[M x N] = A[M x K] * B[K x N]; all row-major with leading dimensions
+// lda / ldb / ldc (in elements). C is overwritten. `pool` may be null.
+void gemm_i16_i32(int M, int N, int K,
+                  const int16_t *A, int lda,
+                  const int16_t *B, int ldb,
+                  int32_t *C, int ldc,
+                  WorkerPool *pool = nullptr);
+
+} // namespace util
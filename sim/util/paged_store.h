@@ -0,0 +1,222 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+// 文件：util/paged_store.h
+// 说明：稀疏分页的模拟内存后备存储。地址空间按 kPageElems 个元素分页，
+// 页表为两级（目录 → 页），页在首次写入时才分配（可选匿名 mmap，由内核
+// 按需提交物理页），未触及的页读出为 0 且不占内存。宿主 RSS 只随实际写入
+// 的数据增长，高地址上的张量不会把其下方的地址空间全部分配出来。
+// map_file 把文件以 MAP_PRIVATE（写时复制）方式直接映射为整页：读取零拷贝，
+// 页缓存可在多个仿真进程间共享，写入只影响本进程的私有副本。
+namespace util {
+
+template<typename T>
+class PagedStore {
+public:
+    static constexpr unsigned kPageBits = 12;   // 4096 elements per page
+    static constexpr uint64_t kPageElems = uint64_t(1) << kPageBits;
+    static constexpr uint64_t kPageMask = kPageElems - 1;
+    static constexpr unsigned kDirBits = 10;    // pages per directory
+    static constexpr uint64_t kDirPages = uint64_t(1) << kDirBits;
+
+    PagedStore() = default;
+    ~PagedStore() { clear(); }
+    PagedStore(const PagedStore&) = delete;
+    PagedStore& operator=(const PagedStore&) = delete;
+
+    // Allocate new pages with anonymous mmap instead of the heap. Only
+    // affects pages allocated afterwards.
+    void set_use_mmap(bool on) { use_mmap_ = on; }
+
+    // Logical extent: accesses at or beyond size() are out of range.
+    // Growing never allocates; shrinking releases pages past the end.
+    uint64_t size() const { return size_; }
+    void resize(uint64_t n) {
+        if (n < size_) {
+            const uint64_t first = (n + kPageMask) >> kPageBits;
+            for_each_page([&](uint64_t p, const T*) { if (p >= first) drop(p); });
+        }
+        size_ = n;
+    }
+
+    T get(uint64_t a) const {
+        const T *page = find(a >> kPageBits);
+        return page ? page[a & kPageMask] : T{};
+    }
+    // Contiguous run starting at `a`: clamps `n` to the end of a's page and
+    // returns the elements, or nullptr if the page is untouched (all zero).
+    const T *run(uint64_t a, size_t &n) const {
+        n = static_cast<size_t>(std::min<uint64_t>(n, kPageElems - (a & kPageMask)));
+        const T *page = find(a >> kPageBits);
+        return page ? page + (a & kPageMask) : nullptr;
+    }
+    // Writable element; allocates its page on first touch.
+    T &at(uint64_t a) {
+        if (a >= size_) size_ = a + 1;
+        return touch(a >> kPageBits)[a & kPageMask];
+    }
+
+    void read(uint64_t a, size_t n, T *dst) const {
+        while (n > 0) {
+            const size_t chunk = static_cast<size_t>(std::min<uint64_t>(n, kPageElems - (a & kPageMask)));
+            const T *page = find(a >> kPageBits);
+            if (page) std::copy_n(page + (a & kPageMask), chunk, dst);
+            else std::fill_n(dst, chunk, T{});
+            a += chunk; dst += chunk; n -= chunk;
+        }
+    }
+    void write(uint64_t a, size_t n, const T *src) {
+        if (n == 0) return;
+        if (a + n > size_) size_ = a + n;
+        while (n > 0) {
+            const size_t chunk = static_cast<size_t>(std::min<uint64_t>(n, kPageElems - (a & kPageMask)));
+            std::copy_n(src, chunk, touch(a >> kPageBits) + (a & kPageMask));
+            a += chunk; src += chunk; n -= chunk;
+        }
+    }
+
+    size_t resident_pages() const { return resident_; }
+    uint64_t resident_bytes() const { return static_cast<uint64_t>(resident_) * kPageElems * sizeof(T); }
+
+    // Release every page and reset the extent to 0.
+    void clear() {
+        for_each_page([&](uint64_t p, const T*) { drop(p); });
+        dirs_.clear();
+        for (const auto &m : mappings_) munmap(m.first, m.second);
+        mappings_.clear();
+        size_ = 0;
+    }
+
+    // Visit resident pages in address order: f(page_index, const T *page).
+    template<typename F>
+    void for_each_page(F &&f) const {
+        for (size_t d = 0; d < dirs_.size(); ++d) {
+            if (!dirs_[d]) continue;
+            for (uint64_t i = 0; i < kDirPages; ++i) {
+                const Page &pg = (*dirs_[d])[i];
+                if (pg.data) f((static_cast<uint64_t>(d) << kDirBits) | i, static_cast<const T*>(pg.data));
+            }
+        }
+    }
+    // Writable page by index (allocated if needed), for bulk restore.
+    T *page_for_write(uint64_t p) { return touch(p); }
+
+    // Place the first `elems` elements of open file `fd` at address `a`.
+    // Whole pages whose file offset is OS-page aligned are mapped
+    // copy-on-write; partial edge pages (or everything, if `a` is not
+    // aligned accordingly) are read into ordinary pages. False on I/O error.
+    bool map_file(int fd, uint64_t elems, uint64_t a) {
+        if (elems == 0) return true;
+        if (a + elems > size_) size_ = a + elems;
+        const uint64_t os_page = static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+        const uint64_t first = (a + kPageMask) >> kPageBits;     // first whole page
+        const uint64_t last = (a + elems) >> kPageBits;          // one past the last whole page
+        const uint64_t off = ((first << kPageBits) - a) * sizeof(T);
+        uint64_t mapped_lo = a + elems, mapped_hi = a + elems;  // empty unless mapped below
+        if (first < last && off % os_page == 0 && (kPageElems * sizeof(T)) % os_page == 0) {
+            const size_t bytes = static_cast<size_t>((last - first) * kPageElems * sizeof(T));
+            void *m = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, static_cast<off_t>(off));
+            if (m != MAP_FAILED) {
+                mappings_.push_back({m, bytes});
+                for (uint64_t p = first; p < last; ++p) {
+                    Page &pg = slot(p);
+                    if (pg.data) drop(p);
+                    pg.data = static_cast<T*>(m) + (p - first) * kPageElems;
+                    pg.kind = kFile;
+                    mapped_++;
+                }
+                mapped_lo = first << kPageBits;
+                mapped_hi = last << kPageBits;
+            }
+        }
+        // copy whatever was not mapped: [a, mapped_lo) and [mapped_hi, a + elems)
+        auto copy = [&](uint64_t lo, uint64_t hi) {
+            std::vector<T> buf;
+            while (lo < hi) {
+                const size_t chunk = static_cast<size_t>(std::min<uint64_t>(hi - lo, kPageElems - (lo & kPageMask)));
+                T *dst = touch(lo >> kPageBits) + (lo & kPageMask);
+                const size_t want = chunk * sizeof(T);
+                const ssize_t got = pread(fd, dst, want, static_cast<off_t>((lo - a) * sizeof(T)));
+                if (got != static_cast<ssize_t>(want)) return false;
+                lo += chunk;
+            }
+            return true;
+        };
+        return copy(a, mapped_lo) && copy(mapped_hi, a + elems);
+    }
+    size_t mapped_pages() const { return mapped_; }
+
+private:
+    enum : uint8_t { kHeap = 0, kAnon = 1, kFile = 2 };
+    struct Page {
+        T *data = nullptr;
+        uint8_t kind = kHeap;
+    };
+    using Dir = std::array<Page, kDirPages>;
+
+    const T *find(uint64_t p) const {
+        const uint64_t d = p >> kDirBits;
+        if (d >= dirs_.size() || !dirs_[d]) return nullptr;
+        return (*dirs_[d])[p & (kDirPages - 1)].data;
+    }
+
+    Page &slot(uint64_t p) {
+        const uint64_t d = p >> kDirBits;
+        if (d >= dirs_.size()) dirs_.resize(static_cast<size_t>(d + 1));
+        if (!dirs_[d]) dirs_[d].reset(new Dir());
+        return (*dirs_[d])[p & (kDirPages - 1)];
+    }
+
+    T *touch(uint64_t p) {
+        Page &pg = slot(p);
+        if (!pg.data) {
+            if (use_mmap_) {
+                void *m = mmap(nullptr, kPageElems * sizeof(T), PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (m != MAP_FAILED) {
+                    pg.data = static_cast<T*>(m);
+                    pg.kind = kAnon;
+                }
+            }
+            if (!pg.data) {
+                pg.data = new T[kPageElems]();
+                pg.kind = kHeap;
+            }
+            resident_++;
+        }
+        return pg.data;
+    }
+
+    void drop(uint64_t p) {
+        Page &pg = (*dirs_[p >> kDirBits])[p & (kDirPages - 1)];
+        if (!pg.data) return;
+        if (pg.kind == kFile) {
+            // the mapping itself is released by clear()
+            pg.data = nullptr;
+            mapped_--;
+            return;
+        }
+        if (pg.kind == kAnon) munmap(pg.data, kPageElems * sizeof(T));
+        else delete[] pg.data;
+        pg.data = nullptr;
+        resident_--;
+    }
+
+    std::vector<std::unique_ptr<Dir>> dirs_;
+    uint64_t size_ = 0;
+    size_t resident_ = 0;   // heap / anonymous pages owned by the store
+    size_t mapped_ = 0;     // file-backed pages (shared page cache until written)
+    std::vector<std::pair<void*, size_t>> mappings_;
+    bool use_mmap_ = false;
+};
+
+} // namespace util
@@ -0,0 +1,33 @@
+#include "util/snapshot.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// 文件：util/snapshot.cpp
+// 说明：SnapshotReader 通过 mmap 直接映射检查点文件，避免整文件读入。
+namespace util {
+
+SnapshotWriter::SnapshotWriter(const std::string &path)
+    : ofs_(path, std::ios::binary | std::ios::trunc) {}
+
+SnapshotReader::SnapshotReader(const std::string &path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat st;
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            base_ = static_cast<const char*>(p);
+            size_ = static_cast<size_t>(st.st_size);
+        }
+    }
+    ::close(fd);
+}
+
+SnapshotReader::~SnapshotReader() {
+    if (base_) ::munmap(const_cast<char*>(base_), size_);
+}
+
+} // namespace util
@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// 文件：util/snapshot.h
+// 说明：仿真检查点（checkpoint）的紧凑二进制格式读写工具。
+// 写入端顺序追加定长字段与数组；读取端以只读 mmap 映射整个文件，
+// 按游标顺序解析，越界或格式不符时返回 false（不抛异常）。
+namespace util {
+
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(const std::string &path);
+    bool good() const { return static_cast<bool>(ofs_); }
+
+    void put_bytes(const void *p, size_t n) { ofs_.write(static_cast<const char*>(p), static_cast<std::streamsize>(n)); }
+
+    template<typename T>
+    void put(const T &v) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot fields must be trivially copyable");
+        put_bytes(&v, sizeof(T));
+    }
+
+    template<typename T>
+    void put_vec(const std::vector<T> &v) {
+        put<uint64_t>(v.size());
+        if (!v.empty()) put_bytes(v.data(), v.size() * sizeof(T));
+    }
+
+    // Four-character section marker checked by the reader.
+    void tag(const char (&t)[5]) { put_bytes(t, 4); }
+
+private:
+    std::ofstream ofs_;
+};
+
+class SnapshotReader {
+public:
+    // Maps `path` read-only; good() is false if the file cannot be mapped.
+    explicit SnapshotReader(const std::string &path);
+    ~SnapshotReader();
+    SnapshotReader(const SnapshotReader&) = delete;
+    SnapshotReader& operator=(const SnapshotReader&) = delete;
+
+    bool good() const { return base_ != nullptr; }
+
+    bool get_bytes(void *p, size_t n) {
+        if (!base_ || n > size_ - pos_) return false;
+        std::memcpy(p, base_ + pos_, n);
+        pos_ += n;
+        return true;
+    }
+
+    template<typename T>
+    bool get(T &v) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot fields must be trivially copyable");
+        return get_bytes(&v, sizeof(T));
+    }
+
+    template<typename T>
+    bool get_vec(std::vector<T> &v) {
+        uint64_t n = 0;
+        if (!get(n)) return false;
+        if (n > (size_ - pos_) / sizeof(T)) return false;
+        v.resize(static_cast<size_t>(n));
+        return n == 0 || get_bytes(v.data(), static_cast<size_t>(n) * sizeof(T));
+    }
+
+    bool expect_tag(const char (&t)[5]) {
+        char buf[4];
+        return get_bytes(buf, 4) && std::memcmp(buf, t, 4) == 0;
+    }
+
+private:
+    const char *base_ = nullptr;
+    size_t size_ = 0;
+    size_t pos_ = 0;
+};
+
+} // namespace util
@@ -0,0 +1,83 @@
+#include "util/worker_pool.h"
+
+// 文件：util/worker_pool.cpp
+// 说明：WorkerPool 实现。分片通过一个 64 位 ticket 领取：
+// [代号 32 位 | 分片总数 16 位 | 下一个分片 16 位]，上一轮迟到的线程因代号不符无法误领分片。
+namespace util {
+
+// Spin iterations before a waiting worker falls back to sleeping.
+static constexpr int kSpinLimit = 4096;
+
+WorkerPool::WorkerPool(int threads) {
+    int extra = threads > 1 ? threads - 1 : 0;
+    workers_.reserve(static_cast<size_t>(extra));
+    // The starting generation is captured here, not in the thread: a worker
+    // scheduled late must still notice a run() or shutdown issued before it
+    // first looked, otherwise it sleeps forever and ~WorkerPool hangs in join.
+    const uint64_t start = generation_.load();
+    for (int i = 0; i < extra; ++i) workers_.emplace_back([this, start]() { worker_loop(start); });
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        stop_.store(true);
+        generation_.fetch_add(1);
+    }
+    cv_.notify_all();
+    for (auto &t : workers_) t.join();
+}
+
+void WorkerPool::drain(uint64_t gen) {
+    for (;;) {
+        uint64_t t = ticket_.load(std::memory_order_acquire);
+        if ((t >> 32) != (gen & 0xffffffffu)) return;
+        uint32_t parts = static_cast<uint32_t>((t >> 16) & 0xffffu);
+        uint32_t part = static_cast<uint32_t>(t & 0xffffu);
+        if (part >= parts) return;
+        if (!ticket_.compare_exchange_weak(t, t + 1, std::memory_order_acq_rel)) continue;
+        (*job_.load(std::memory_order_acquire))(static_cast<int>(part));
+        done_parts_.fetch_add(1, std::memory_order_acq_rel);
+    }
+}
+
+void WorkerPool::run(int parts, const std::function<void(int)> &fn) {
+    if (parts <= 0) return;
+    if (workers_.empty() || parts == 1 || parts > 0xffff) {
+        for (int p = 0; p < parts; ++p) fn(p);
+        return;
+    }
+    uint64_t gen = generation_.load(std::memory_order_relaxed) + 1;
+    job_.store(&fn, std::memory_order_release);
+    done_parts_.store(0, std::memory_order_release);
+    ticket_.store(((gen & 0xffffffffu) << 32) | (static_cast<uint64_t>(parts) << 16),
+                  std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lk(mtx_);
+        generation_.store(gen, std::memory_order_release);
+    }
+    if (sleepers_.load(std::memory_order_acquire) > 0) cv_.notify_all();
+
+    drain(gen);
+    // barrier: wait for the parts claimed by other workers
+    while (done_parts_.load(std::memory_order_acquire) < parts) std::this_thread::yield();
+}
+
+void WorkerPool::worker_loop(uint64_t seen) {
+    for (;;) {
+        int spins = 0;
+        while (generation_.load(std::memory_order_acquire) == seen) {
+            if (++spins < kSpinLimit) { std::this_thread::yield(); continue; }
+            std::unique_lock<std::mutex> lk(mtx_);
+            sleepers_.fetch_add(1);
+            cv_.wait(lk, [&]() { return generation_.load() != seen; });
+            sleepers_.fetch_sub(1);
+            break;
+        }
+        seen = generation_.load(std::memory_order_acquire);
+        if (stop_.load()) return;
+        drain(seen);
+    }
+}
+
+} // namespace util
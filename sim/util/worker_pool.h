@@ -0,0 +1,47 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 文件：util/worker_pool.h
+// 说明：常驻工作线程池，用于按行带（row band）并行执行每周期的阵列阶段。
+// 每次 `run` 相当于一个屏障：所有分片完成后才返回，调用线程也参与计算。
+// 每周期调用频繁，因此等待采用短暂自旋 + 让出，长时间空闲时才进入条件变量休眠。
+namespace util {
+
+class WorkerPool {
+public:
+    // `threads` is the total number of participants including the caller.
+    explicit WorkerPool(int threads);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    int size() const { return static_cast<int>(workers_.size()) + 1; }
+
+    // Execute fn(part) for every part in [0, parts) and return when all have
+    // finished. Parts are claimed dynamically; callers must make them write
+    // disjoint data so the result does not depend on the assignment.
+    void run(int parts, const std::function<void(int)> &fn);
+
+private:
+    std::vector<std::thread> workers_;
+    std::mutex mtx_;
+    std::condition_variable cv_;
+    std::atomic<uint64_t> generation_{0};
+    std::atomic<uint64_t> ticket_{0};
+    std::atomic<int> done_parts_{0};
+    std::atomic<int> sleepers_{0};
+    std::atomic<bool> stop_{false};
+    std::atomic<const std::function<void(int)>*> job_{nullptr};
+
+    void worker_loop(uint64_t seen);
+    void drain(uint64_t gen);
+};
+
+} // namespace util